@@ -0,0 +1,61 @@
+/**
+ * Hive Core - Background Battery Sampling
+ */
+
+#include "HiveBattery.h"
+#include "HiveLog.h"
+#include "HivePerf.h"
+
+HIVE_PER_BEE HiveBattery hiveBattery;
+
+bool HiveBattery::begin(int pin, float dividerRatio, uint32_t intervalMs) {
+    if (_task || pin < 0) return false;
+
+    _pin = pin;
+    _dividerRatio = dividerRatio;
+    _intervalMs = intervalMs;
+    pinMode(_pin, INPUT);
+
+    if (xTaskCreate(task, "battery", 2048, this, HIVE_BATTERY_TASK_PRIORITY, &_task) != pdPASS) {
+        _task = nullptr;
+        mqttLog("[Battery] Failed to start sampling task\n");
+        return false;
+    }
+    return true;
+}
+
+void HiveBattery::task(void* param) {
+    HiveBattery* battery = (HiveBattery*)param;
+    HIVE_PERF_TASK();
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;) {
+        battery->sample();
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(battery->_intervalMs));
+    }
+}
+
+void HiveBattery::sample() {
+    uint16_t raw = analogRead(_pin);
+    uint32_t mv = analogReadMilliVolts(_pin);  // Per-chip eFuse calibration
+
+    portENTER_CRITICAL(&_mux);
+    _raw = raw;
+    if (_samples == 0) {
+        _pinMv = mv;
+    } else {
+        _pinMv += HIVE_BATTERY_EMA_ALPHA * ((float)mv - _pinMv);
+    }
+    _samples++;
+    portEXIT_CRITICAL(&_mux);
+}
+
+HiveBatteryReading HiveBattery::read() {
+    HiveBatteryReading reading;
+    portENTER_CRITICAL(&_mux);
+    reading.pinVoltage = _pinMv / 1000.0f;
+    reading.raw = _raw;
+    reading.samples = _samples;
+    portEXIT_CRITICAL(&_mux);
+    reading.voltage = reading.pinVoltage * _dividerRatio;
+    return reading;
+}
@@ -0,0 +1,61 @@
+/**
+ * Hive Core - Background Battery Sampling
+ *
+ * A low-priority task reads the battery pin with the eFuse-calibrated
+ * analogReadMilliVolts() and keeps an exponential moving average, so no
+ * bee stalls loop() on the ADC. Reading the battery is just a copy of the
+ * latest filtered value:
+ *
+ *   hiveBattery.begin(BATTERY_ADC_PIN, 2.0f);  // pin, voltage divider ratio
+ *   HiveBatteryReading battery = hiveBattery.read();
+ *   if (battery.samples > 0) state.batteryVoltage = battery.voltage;
+ *
+ * The first sample seeds the average, so readings are valid right away.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "HivePlatform.h"
+
+#ifndef HIVE_BATTERY_SAMPLE_MS
+#define HIVE_BATTERY_SAMPLE_MS 100      // One conversion every 100ms
+#endif
+
+#ifndef HIVE_BATTERY_EMA_ALPHA
+#define HIVE_BATTERY_EMA_ALPHA 0.05f    // ~2s time constant at 100ms
+#endif
+
+#ifndef HIVE_BATTERY_TASK_PRIORITY
+#define HIVE_BATTERY_TASK_PRIORITY 1    // Same as loop() - time-sliced, never preempts it
+#endif
+
+struct HiveBatteryReading {
+    float voltage;       // Filtered battery voltage (after the divider)
+    float pinVoltage;    // Filtered voltage at the ADC pin
+    uint16_t raw;        // Last raw 12-bit conversion (debug screens)
+    uint32_t samples;    // Conversions so far (0 = no reading yet)
+};
+
+class HiveBattery {
+public:
+    bool begin(int pin, float dividerRatio, uint32_t intervalMs = HIVE_BATTERY_SAMPLE_MS);
+    HiveBatteryReading read();
+    bool running() const { return _task != nullptr; }
+
+private:
+    static void task(void* param);
+    void sample();
+
+    int _pin = -1;
+    float _dividerRatio = 1.0f;
+    uint32_t _intervalMs = HIVE_BATTERY_SAMPLE_MS;
+    float _pinMv = 0;        // EMA of calibrated pin millivolts
+    uint16_t _raw = 0;
+    uint32_t _samples = 0;
+    TaskHandle_t _task = nullptr;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+extern HIVE_PER_BEE HiveBattery hiveBattery;
@@ -0,0 +1,158 @@
+/**
+ * Hive Core - On-Target Benchmarks
+ */
+
+#include "HiveBench.h"
+#include "HiveCore.h"
+
+#if HIVE_BENCH
+
+HIVE_PER_BEE HiveBench hiveBench;
+
+// ============== Results ==============
+
+void HiveBench::start() {
+    JsonDocument doc;
+    doc["firmware"] = hive.info().firmware;
+    doc["type"] = hive.info().type;
+    doc["cpu_mhz"] = getCpuFrequencyMhz();
+    doc["free_heap"] = ESP.getFreeHeap();
+
+    Serial.print("BENCH ");
+    serializeJson(doc, Serial);
+    Serial.println();
+}
+
+void HiveBench::finish() {
+    Serial.printf("BENCH {\"done\":true,\"results\":%u,\"over_budget\":%lu}\n",
+                  (unsigned)_count, (unsigned long)_overBudget);
+}
+
+void HiveBench::begin(const char* name, uint32_t budgetUs) {
+    _current = {};
+    _current.name = name;
+    _current.budgetUs = budgetUs;
+    _current.minUs = UINT32_MAX;
+    _totalUs = 0;
+}
+
+void HiveBench::sample(uint32_t us) {
+    _current.iterations++;
+    _totalUs += us;
+    if (us < _current.minUs) _current.minUs = us;
+    if (us > _current.maxUs) _current.maxUs = us;
+}
+
+void HiveBench::bytes(size_t bytes, size_t maxBytes) {
+    _current.bytes = bytes;
+    _current.maxBytes = maxBytes;
+}
+
+static bool fits(const HiveBenchResult& result) {
+    return result.maxBytes == 0 || result.bytes <= result.maxBytes;
+}
+
+static bool withinBudget(const HiveBenchResult& result) {
+    return (result.budgetUs == 0 || result.avgUs <= result.budgetUs) && fits(result);
+}
+
+void HiveBench::end() {
+    if (_current.iterations == 0) {
+        Serial.printf("[BENCH] %s: no samples\n", _current.name);
+        return;
+    }
+    _current.avgUs = (uint32_t)(_totalUs / _current.iterations);
+    if (!withinBudget(_current)) _overBudget++;
+
+    print(_current);
+    if (_count < HIVE_BENCH_MAX_RESULTS) _results[_count++] = _current;
+}
+
+void HiveBench::print(const HiveBenchResult& result) {
+    Serial.printf("BENCH {\"name\":\"%s\",\"iters\":%lu,\"avg_us\":%lu,\"min_us\":%lu,\"max_us\":%lu,"
+                  "\"budget_us\":%lu,",
+                  result.name, (unsigned long)result.iterations, (unsigned long)result.avgUs,
+                  (unsigned long)result.minUs, (unsigned long)result.maxUs, (unsigned long)result.budgetUs);
+    if (result.maxBytes > 0) {
+        Serial.printf("\"bytes\":%lu,\"max_bytes\":%lu,", (unsigned long)result.bytes,
+                      (unsigned long)result.maxBytes);
+    }
+    Serial.printf("\"ok\":%s}\n", withinBudget(result) ? "true" : "false");
+    if (!fits(result)) {
+        Serial.printf("[BENCH] %s: %lu bytes won't fit (max %lu), raise HIVE_TX_BUFFER_SIZE\n", result.name,
+                      (unsigned long)result.bytes, (unsigned long)result.maxBytes);
+    }
+}
+
+// ============== Core Benchmarks ==============
+
+void HiveBench::runCore() {
+    // What publishHealth() does before handing the payload to espMqttClient.
+    // HiveMessage drops a payload that fills the TX buffer, so report the
+    // full size rather than what serializeJson() truncated it to.
+    static char payload[HIVE_TX_BUFFER_SIZE];
+    size_t healthBytes = 0;
+    begin("health_json");
+    for (int i = 0; i < 50; i++) {
+        uint32_t started = micros();
+        HiveMessage msg;
+        hive.buildHealth(msg.doc);
+        serializeJson(msg.doc, payload, sizeof(payload));
+        sample(micros() - started);
+        healthBytes = measureJson(msg.doc);
+    }
+    bytes(healthBytes, HIVE_TX_BUFFER_SIZE - 2);  // HiveMessage::send() limit
+    end();
+
+    // Serial print + ring insert (~21 chars, about 1.8 ms at 115200 baud).
+    // Each line is unqueued again untimed, so the ring never takes the drop
+    // path and boot logs still ship; a ring already full loses one to make room.
+    HiveLogStats logs = hiveLogStats();
+    size_t keep = logs.capacity > 0 && logs.queued >= logs.capacity ? logs.capacity - 1 : logs.queued;
+    hiveLogTruncate(keep);
+    begin("mqtt_log", 2500);
+    for (uint32_t line = 1; line <= 500; line++) {
+        uint32_t started = micros();
+        mqttLog("[BENCH] Log line %lu\n", (unsigned long)line);
+        sample(micros() - started);
+        hiveLogTruncate(keep);
+    }
+    end();
+}
+
+// ============== Publish ==============
+
+void HiveBench::publish() {
+    if (_published || _count == 0) return;
+
+    HiveMessage msg;
+    JsonDocument& doc = msg.doc;
+    doc["firmware"] = hive.info().firmware;
+    doc["type"] = hive.info().type;
+    doc["cpu_mhz"] = getCpuFrequencyMhz();
+    doc["over_budget"] = _overBudget;
+
+    JsonArray results = doc["results"].to<JsonArray>();
+    for (size_t i = 0; i < _count; i++) {
+        const HiveBenchResult& result = _results[i];
+        JsonObject item = results.add<JsonObject>();
+        item["name"] = result.name;
+        item["iters"] = result.iterations;
+        item["avg_us"] = result.avgUs;
+        item["min_us"] = result.minUs;
+        item["max_us"] = result.maxUs;
+        if (result.budgetUs > 0) item["budget_us"] = result.budgetUs;
+        if (result.maxBytes > 0) {
+            item["bytes"] = result.bytes;
+            item["max_bytes"] = result.maxBytes;
+        }
+    }
+
+    String topic = hive.topicFor(hive.deviceId().c_str(), "bench");
+    if (msg.publish(topic.c_str(), 1, true)) {
+        _published = true;
+        mqttLog("[BENCH] Published %u results\n", (unsigned)_count);
+    }
+}
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ * Hive Core - On-Target Benchmarks
+ *
+ * Compile-time opt-in (-DHIVE_BENCH=1, see the *-bench envs in
+ * platformio.ini). A bee runs its benchmarks once at the end of setup(),
+ * before its tasks start, so nothing competes for the CPU:
+ *
+ *   hiveBench.start();
+ *   hiveBench.runCore();                               // health JSON, mqttLog
+ *   hiveBench.run("drawHeart", 200, 400, [] {          // name, iterations, budget (us)
+ *       drawHeart(heartSprite, 160, 85, 40, COLOR_HEART);
+ *   });
+ *   hiveBench.finish();
+ *
+ * Every benchmark prints one machine-readable line on Serial,
+ *
+ *   BENCH {"name":"drawHeart","iters":200,"avg_us":212,"min_us":205,"max_us":260,"budget_us":400,"ok":true}
+ *
+ * and the whole run is published retained on .../bench (with firmware,
+ * type and CPU clock) on the first MQTT connect, so results can be
+ * compared release to release (tools/bench_report.py). A budget of 0
+ * means "measure only". Benchmarks that need untimed setup between
+ * samples (e.g. waiting out an ultrasonic echo) use begin/sample/end;
+ * payload benchmarks also report their size with bytes(), and a payload
+ * over its limit fails the run like a blown time budget.
+ *
+ * With HIVE_BENCH 0 (default) nothing here is compiled.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "HivePlatform.h"
+
+#ifndef HIVE_BENCH
+#define HIVE_BENCH 0                    // 1 = benchmark build
+#endif
+
+#ifndef HIVE_BENCH_MAX_RESULTS
+#define HIVE_BENCH_MAX_RESULTS 16
+#endif
+
+#if HIVE_BENCH
+
+struct HiveBenchResult {
+    const char* name;
+    uint32_t iterations;
+    uint32_t avgUs;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint32_t budgetUs;    // 0 = no budget
+    uint32_t bytes;       // Payload size (0 = not a payload benchmark)
+    uint32_t maxBytes;    // Largest payload that can be sent
+};
+
+class HiveBench {
+public:
+    // Header line (firmware, type, CPU clock) before the first result
+    void start();
+    // Summary line; results stay around for publish()
+    void finish();
+
+    template <typename Fn>
+    void run(const char* name, uint32_t iterations, uint32_t budgetUs, Fn fn) {
+        begin(name, budgetUs);
+        for (uint32_t i = 0; i < iterations; i++) {
+            uint32_t started = micros();
+            fn();
+            sample(micros() - started);
+        }
+        end();
+    }
+
+    // Manual timing: only what goes into sample() counts
+    void begin(const char* name, uint32_t budgetUs = 0);
+    void sample(uint32_t us);
+    void bytes(size_t bytes, size_t maxBytes);
+    void end();
+
+    // Benchmarks every bee shares: health JSON build + serialize, mqttLog()
+    void runCore();
+
+    // Retained results on .../bench (HiveCore calls this on connect)
+    void publish();
+
+    size_t count() const { return _count; }
+    uint32_t overBudget() const { return _overBudget; }
+
+private:
+    void print(const HiveBenchResult& result);
+
+    HiveBenchResult _results[HIVE_BENCH_MAX_RESULTS] = {};
+    size_t _count = 0;
+    uint32_t _overBudget = 0;
+    bool _published = false;
+
+    // Benchmark in progress
+    HiveBenchResult _current = {};
+    uint64_t _totalUs = 0;
+};
+
+extern HIVE_PER_BEE HiveBench hiveBench;
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * Hive Core - Broker Selection
+ */
+
+#include "HiveBroker.h"
+
+size_t HiveBrokers::begin(const HiveConfig& config) {
+    char list[sizeof(config.mqttServer)];
+    strlcpy(list, config.mqttServer, sizeof(list));
+
+    _count = 0;
+    char* save = nullptr;
+    for (char* entry = strtok_r(list, ", ", &save); entry && _count < HIVE_MAX_BROKERS;
+         entry = strtok_r(nullptr, ", ", &save)) {
+        HiveBroker& broker = _brokers[_count];
+        memset(&broker, 0, sizeof(broker));
+        broker.port = config.mqttPort;
+        broker.rttMs = -1;
+
+        char* colon = strchr(entry, ':');
+        if (colon) {
+            *colon = '\0';
+            int port = atoi(colon + 1);
+            if (port > 0 && port < 65536) broker.port = port;
+        }
+        strlcpy(broker.host, entry, sizeof(broker.host));
+        if (broker.host[0]) _count++;
+    }
+
+    // Empty or unparseable setting: fall back to the default broker
+    if (_count == 0) {
+        HiveBroker& broker = _brokers[0];
+        memset(&broker, 0, sizeof(broker));
+        strlcpy(broker.host, HIVE_DEFAULT_MQTT_SERVER, sizeof(broker.host));
+        broker.port = config.mqttPort;
+        broker.rttMs = -1;
+        _count = 1;
+    }
+
+    _active = 0;
+    _tried = 0;
+    _roundOpen = false;
+    return _count;
+}
+
+bool HiveBrokers::heldOff(const HiveBroker& broker) const {
+    return broker.failedAt != 0 && millis() - broker.failedAt < HIVE_BROKER_HOLDOFF;
+}
+
+const HiveBroker& HiveBrokers::next() {
+    if (!_roundOpen || _tried == allMask()) {
+        _tried = 0;
+        _roundOpen = true;
+    }
+
+    // Healthy before held off, measured before never connected, then fastest;
+    // strict comparisons keep config order on ties
+    int best = -1;
+    for (size_t i = 0; i < _count; i++) {
+        if (_tried & (1u << i)) continue;
+        if (best < 0) {
+            best = i;
+            continue;
+        }
+
+        const HiveBroker& a = _brokers[i];
+        const HiveBroker& b = _brokers[best];
+        if (heldOff(a) != heldOff(b)) {
+            if (!heldOff(a)) best = i;
+        } else if ((a.rttMs < 0) != (b.rttMs < 0)) {
+            if (a.rttMs >= 0) best = i;
+        } else if (a.rttMs < b.rttMs) {
+            best = i;
+        }
+    }
+
+    _active = best;
+    _tried |= 1u << best;
+    return _brokers[_active];
+}
+
+void HiveBrokers::connected(uint32_t connackMs) {
+    HiveBroker& broker = _brokers[_active];
+    broker.failures = 0;
+    broker.failedAt = 0;
+    broker.rttMs = connackMs > INT16_MAX ? INT16_MAX : (int16_t)connackMs;
+    _connackMs = connackMs;
+    _roundOpen = false;  // Next outage re-ranks from the latest figures
+
+    if (_lastConnected >= 0 && (size_t)_lastConnected != _active) _failovers++;
+    _lastConnected = _active;
+}
+
+void HiveBrokers::failed() {
+    HiveBroker& broker = _brokers[_active];
+    if (broker.failures < UINT16_MAX) broker.failures++;
+    broker.failedAt = millis() | 1;  // Never 0 (= healthy); rttMs kept for after the holdoff
+}
@@ -0,0 +1,76 @@
+/**
+ * Hive Core - Broker Selection
+ *
+ * config.mqttServer holds an ordered, comma-separated broker list; a port
+ * after a colon overrides config.mqttPort for that broker:
+ *
+ *   192.168.0.95,192.168.0.10:1884
+ *
+ * Each connect round tries the brokers fastest first, by the CONNECT to
+ * CONNACK time of their last successful connect; brokers never connected
+ * to come after, in config order. Nothing is probed up front, so picking
+ * a broker never blocks hive.loop(). A broker that fails
+ * to CONNACK within HIVE_BROKER_CONNECT_TIMEOUT is held off for
+ * HIVE_BROKER_HOLDOFF and the next one is tried right away; the reconnect
+ * backoff in HiveCore only applies once every broker in the round failed.
+ * A single-broker list always uses that broker.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "HiveConfig.h"
+
+#ifndef HIVE_MAX_BROKERS
+#define HIVE_MAX_BROKERS 3
+#endif
+
+#ifndef HIVE_BROKER_CONNECT_TIMEOUT
+#define HIVE_BROKER_CONNECT_TIMEOUT 5000   // CONNECT to CONNACK before failing over
+#endif
+
+#ifndef HIVE_BROKER_HOLDOFF
+#define HIVE_BROKER_HOLDOFF 60000          // Failed broker sorts last for this long
+#endif
+
+struct HiveBroker {
+    char host[48];
+    uint16_t port;
+    int16_t rttMs;             // CONNACK time of the last good connect, -1 = never connected
+    uint16_t failures;         // Failed connects in a row
+    unsigned long failedAt;    // millis() of the last failure (0 = healthy)
+};
+
+class HiveBrokers {
+public:
+    // Parse config.mqttServer; returns the number of brokers
+    size_t begin(const HiveConfig& config);
+
+    // Pick the broker for the next attempt; never blocks
+    const HiveBroker& next();
+    bool lastInRound() const { return _tried == allMask(); }
+
+    // Outcome of the attempt started by next()
+    void connected(uint32_t connackMs);
+    void failed();
+
+    const HiveBroker& active() const { return _brokers[_active]; }
+    const HiveBroker& at(size_t i) const { return _brokers[i]; }
+    size_t count() const { return _count; }
+    uint32_t connackMs() const { return _connackMs; }
+    uint32_t failovers() const { return _failovers; }
+
+private:
+    bool heldOff(const HiveBroker& broker) const;
+    uint8_t allMask() const { return (uint8_t)((1u << _count) - 1); }
+
+    HiveBroker _brokers[HIVE_MAX_BROKERS];
+    size_t _count = 0;
+    size_t _active = 0;
+    uint8_t _tried = 0;        // Bit per broker already tried this round
+    bool _roundOpen = false;
+    uint32_t _connackMs = 0;
+    uint32_t _failovers = 0;   // Connects that landed on a different broker
+    int _lastConnected = -1;
+};
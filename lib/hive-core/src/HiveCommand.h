@@ -0,0 +1,63 @@
+/**
+ * Hive Core - Command Dispatch
+ *
+ * Bees list their capabilities in a table; instance names are hashed at
+ * compile time, so a command costs one hash of the incoming instance and
+ * a scan of 32-bit compares however many capabilities the bee has:
+ *
+ *   static const HiveCommand commands[] = {
+ *       {"powerSwitch", onPowerSwitch},
+ *       {"loveMessage", onLoveMessage},
+ *   };
+ *   hive.onCommands(commands);
+ *
+ * Values are dispatched the same way, with the hash as case label:
+ *
+ *   switch (hiveHash(capability["value"] | "")) {
+ *       case hiveHash("raise"): startLift("raise"); break;
+ *       case hiveHash("stop"): stopLift("manual"); break;
+ *   }
+ *
+ * Two names with the same hash in one switch fail to compile. Instances
+ * not in the table still reach the onCommand() hook.
+ *
+ * Incoming set-topic payloads are parsed with an ArduinoJson filter, so
+ * only "capability" and "link_seq" are materialized, into a static RX
+ * arena (HIVE_RX_ARENA_SIZE) instead of the heap. A bee whose handlers
+ * read other top-level fields adds them in setup():
+ *
+ *   hive.commandFilter()["from"] = true;
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#ifndef HIVE_RX_ARENA_SIZE
+#define HIVE_RX_ARENA_SIZE 1024         // Filtered command document
+#endif
+
+#ifndef HIVE_MAX_TOPICS
+#define HIVE_MAX_TOPICS 4               // Extra subscriptions via hive.onTopic()
+#endif
+
+// FNV-1a; constexpr so names become constants in tables and case labels
+constexpr uint32_t hiveHash(const char* text) {
+    uint32_t hash = 2166136261u;
+    while (*text) {
+        hash = (hash ^ (uint8_t)*text++) * 16777619u;
+    }
+    return hash;
+}
+
+typedef void (*HiveCommandHook)(const char* instance, JsonObject capability, JsonDocument& doc);
+
+struct HiveCommand {
+    constexpr HiveCommand(const char* instance, HiveCommandHook handler)
+        : hash(hiveHash(instance)), instance(instance), handler(handler) {}
+
+    uint32_t hash;
+    const char* instance;
+    HiveCommandHook handler;
+};
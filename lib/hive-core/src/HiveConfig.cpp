@@ -0,0 +1,120 @@
+/**
+ * Hive Core - Configuration Storage
+ */
+
+#include "HiveConfig.h"
+
+#define HIVE_CONFIG_MAGIC 0x4843  // "HC"
+#define HIVE_CONFIG_KEY "config"
+
+HIVE_PER_BEE HiveConfigStore hiveConfig;
+
+// Bitwise CRC-32 (IEEE); a few hundred bytes, once per load or save
+static uint32_t configCrc(const uint8_t* bytes, size_t len) {
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+void loadHiveConfig(Preferences& prefs, HiveConfig& config, const char* defaultName) {
+    prefs.getString("deviceName", config.deviceName, sizeof(config.deviceName));
+    if (strlen(config.deviceName) == 0) {
+        strncpy(config.deviceName, defaultName, sizeof(config.deviceName) - 1);
+        config.deviceName[sizeof(config.deviceName) - 1] = '\0';
+    }
+
+    prefs.getString("mqttServer", config.mqttServer, sizeof(config.mqttServer));
+    if (strlen(config.mqttServer) == 0) {
+        strcpy(config.mqttServer, HIVE_DEFAULT_MQTT_SERVER);
+    }
+
+    config.mqttPort = prefs.getInt("mqttPort", HIVE_DEFAULT_MQTT_PORT);
+
+    prefs.getString("mqttUser", config.mqttUser, sizeof(config.mqttUser));
+    prefs.getString("mqttPass", config.mqttPass, sizeof(config.mqttPass));
+
+    prefs.getString("topicPrefix", config.topicPrefix, sizeof(config.topicPrefix));
+    if (strlen(config.topicPrefix) == 0) {
+        strcpy(config.topicPrefix, HIVE_DEFAULT_TOPIC_PREFIX);
+    }
+}
+
+HiveConfigSource HiveConfigStore::load(const char* ns, void* config, size_t size, uint8_t version) {
+    unsigned long started = micros();
+    uint8_t blob[HIVE_CONFIG_MAX_SIZE];
+    HiveConfigHeader header = {};
+    size_t len = 0;
+
+    Preferences prefs;
+    if (prefs.begin(ns, true)) {
+        len = prefs.getBytes(HIVE_CONFIG_KEY, blob, sizeof(blob));
+        prefs.end();
+    }
+    if (len >= sizeof(header)) memcpy(&header, blob, sizeof(header));
+
+    const uint8_t* payload = blob + sizeof(header);
+    _stored = false;
+    _storedVersion = header.beeVersion;
+    HiveConfigSource source;
+
+    if (len < sizeof(header) || header.magic != HIVE_CONFIG_MAGIC) {
+        Serial.println("[Config] No config blob, migrating per-field keys");
+        source = HIVE_CONFIG_LEGACY;
+    } else if (header.size != len - sizeof(header) || header.crc != configCrc(payload, header.size)) {
+        Serial.println("[Config] Config blob corrupt, falling back to per-field keys");
+        source = HIVE_CONFIG_LEGACY;
+    } else if (header.coreVersion != HIVE_CONFIG_VERSION) {
+        Serial.printf("[Config] Core layout v%u -> v%u, migrating per-field keys\n",
+                      header.coreVersion, HIVE_CONFIG_VERSION);
+        source = HIVE_CONFIG_LEGACY;
+    } else if (header.beeVersion != version || header.size != size) {
+        // Fields are only appended, so the stored bytes are a prefix of the new layout
+        memcpy(config, payload, header.size < size ? header.size : size);
+        Serial.printf("[Config] Layout v%u -> v%u (%u -> %u bytes)\n", header.beeVersion, version,
+                      header.size, (unsigned)size);
+        source = HIVE_CONFIG_UPGRADED;
+    } else {
+        memcpy(config, payload, size);
+        _crc = header.crc;
+        _stored = true;
+        source = HIVE_CONFIG_BLOB;
+    }
+
+    _loadUs = micros() - started;
+    return source;
+}
+
+bool HiveConfigStore::save(const char* ns, const void* config, size_t size, uint8_t version) {
+    uint32_t crc = configCrc((const uint8_t*)config, size);
+    if (_stored && crc == _crc) return false;
+
+    unsigned long started = micros();
+    uint8_t blob[HIVE_CONFIG_MAX_SIZE];
+    HiveConfigHeader header = {HIVE_CONFIG_MAGIC, HIVE_CONFIG_VERSION, version, (uint16_t)size, 0, crc};
+    memcpy(blob, &header, sizeof(header));
+    memcpy(blob + sizeof(header), config, size);
+
+    Preferences prefs;
+    size_t written = 0;
+    if (prefs.begin(ns, false)) {
+        written = prefs.putBytes(HIVE_CONFIG_KEY, blob, sizeof(header) + size);
+        prefs.end();
+    }
+    _saveUs = micros() - started;
+
+    if (written != sizeof(header) + size) {
+        Serial.printf("[Config] Write to NVS \"%s\" failed\n", ns);
+        return false;
+    }
+
+    _crc = crc;
+    _stored = true;
+    _storedVersion = version;
+    _writes++;
+    return true;
+}
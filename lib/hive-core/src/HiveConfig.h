@@ -0,0 +1,117 @@
+/**
+ * Hive Core - Configuration Storage
+ *
+ * Core config fields every bee stores in Preferences. Bees extend this
+ * with their own fields:
+ *
+ *   struct DeviceConfig : HiveConfig {
+ *       unsigned long liftDuration = DEFAULT_LIFT_DURATION;
+ *   } config;
+ *
+ * The whole struct is one NVS blob ("config" in the bee's namespace)
+ * behind a header with the layout versions, the size and a CRC-32, so
+ * boot is a single read:
+ *
+ *   HiveConfigSource source = hiveConfig.load("homecontrol", config, CONFIG_VERSION);
+ *   if (source == HIVE_CONFIG_LEGACY) {
+ *       preferences.begin("homecontrol", true);
+ *       loadHiveConfig(preferences, config, "ESP32 Device");  // + the bee's own keys
+ *       preferences.end();
+ *   }
+ *   if (source != HIVE_CONFIG_BLOB) saveConfig();
+ *
+ *   void saveConfig() {
+ *       if (hiveConfig.save("homecontrol", config, CONFIG_VERSION)) Serial.println("[Config] Saved");
+ *   }
+ *
+ * save() only writes when the struct differs from what was last read or
+ * written, so saving after WiFiManager or the /config form costs no flash
+ * when nothing changed. Bees append new fields with a default initializer
+ * and bump CONFIG_VERSION: an older blob fills the fields it has and the
+ * new ones keep their defaults (HIVE_CONFIG_UPGRADED). A change to
+ * HiveConfig itself bumps HIVE_CONFIG_VERSION and falls back to the
+ * per-field keys, which are read once and then left in place.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+#include <type_traits>
+
+#include "HivePlatform.h"
+
+#define HIVE_DEFAULT_MQTT_SERVER "192.168.0.95"  // remusPi
+#define HIVE_DEFAULT_MQTT_PORT 1883
+#define HIVE_DEFAULT_TOPIC_PREFIX "homecontrol"
+
+#define HIVE_CONFIG_VERSION 1           // HiveConfig layout below
+
+#ifndef HIVE_CONFIG_MAX_SIZE
+#define HIVE_CONFIG_MAX_SIZE 512        // Largest DeviceConfig; the blob is staged on the stack
+#endif
+
+struct HiveConfig {
+    char deviceName[32];
+    char mqttServer[64];
+    int mqttPort;
+    char mqttUser[32];
+    char mqttPass[32];
+    char topicPrefix[32];
+};
+
+// Per-field keys of the pre-blob format; only read to migrate.
+// Call between preferences.begin() and preferences.end()
+void loadHiveConfig(Preferences& prefs, HiveConfig& config, const char* defaultName);
+
+// Where hiveConfig.load() got the config from
+enum HiveConfigSource : uint8_t {
+    HIVE_CONFIG_BLOB = 0,   // Current blob, nothing to do
+    HIVE_CONFIG_UPGRADED,   // Older bee layout: stored prefix loaded, newer fields at defaults
+    HIVE_CONFIG_LEGACY,     // No usable blob: caller reads the per-field keys
+};
+
+struct HiveConfigHeader {
+    uint16_t magic;
+    uint8_t coreVersion;    // HIVE_CONFIG_VERSION
+    uint8_t beeVersion;     // The bee's CONFIG_VERSION
+    uint16_t size;          // Payload bytes (sizeof(DeviceConfig))
+    uint16_t reserved;
+    uint32_t crc;           // CRC-32 of the payload
+};
+
+class HiveConfigStore {
+public:
+    template <typename T>
+    HiveConfigSource load(const char* ns, T& config, uint8_t version) {
+        static_assert(std::is_base_of<HiveConfig, T>::value, "config must extend HiveConfig");
+        static_assert(std::is_trivially_copyable<T>::value, "config is stored as raw bytes");
+        static_assert(sizeof(T) + sizeof(HiveConfigHeader) <= HIVE_CONFIG_MAX_SIZE, "raise HIVE_CONFIG_MAX_SIZE");
+        return load(ns, &config, sizeof(T), version);
+    }
+
+    // True if written, false if unchanged (or the write failed)
+    template <typename T>
+    bool save(const char* ns, const T& config, uint8_t version) {
+        return save(ns, &config, sizeof(T), version);
+    }
+
+    uint8_t storedVersion() const { return _storedVersion; }  // Bee layout found on load
+    uint32_t loadUs() const { return _loadUs; }
+    uint32_t saveUs() const { return _saveUs; }                // Last actual write
+    uint32_t writes() const { return _writes; }                // Since boot
+
+private:
+    HiveConfigSource load(const char* ns, void* config, size_t size, uint8_t version);
+    bool save(const char* ns, const void* config, size_t size, uint8_t version);
+
+    uint32_t _crc = 0;           // Payload CRC last read or written
+    bool _stored = false;        // _crc matches a current-format blob in NVS
+    uint8_t _storedVersion = 0;
+    uint32_t _loadUs = 0;
+    uint32_t _saveUs = 0;
+    uint32_t _writes = 0;
+};
+
+extern HIVE_PER_BEE HiveConfigStore hiveConfig;
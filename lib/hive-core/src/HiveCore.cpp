@@ -0,0 +1,647 @@
+/**
+ * Hive Core - Shared Bee Stack
+ */
+
+#include "HiveCore.h"
+
+#include <esp_random.h>
+
+// ============== Global Objects ==============
+
+HIVE_PER_BEE HiveCore hive;
+HIVE_PER_BEE espMqttClient mqttClient;
+
+// Incoming commands; only the MQTT task parses into it, one message at a time
+alignas(8) static HIVE_PER_BEE uint8_t rxPool[HIVE_RX_ARENA_SIZE];
+static HIVE_PER_BEE HiveArena rxArena(rxPool, sizeof(rxPool));
+
+// ============== Helpers ==============
+
+String getDeviceId() {
+    uint64_t chipid = ESP.getEfuseMac();
+    char id[13];
+    sprintf(id, "%04x%08x", (uint16_t)(chipid >> 32), (uint32_t)chipid);
+    return String(id);
+}
+
+const char* disconnectReasonName(espMqttClientTypes::DisconnectReason reason) {
+    switch (reason) {
+        case espMqttClientTypes::DisconnectReason::TCP_DISCONNECTED:
+            return "TCP_DISCONNECTED";
+        case espMqttClientTypes::DisconnectReason::MQTT_UNACCEPTABLE_PROTOCOL_VERSION:
+            return "BAD_PROTOCOL";
+        case espMqttClientTypes::DisconnectReason::MQTT_IDENTIFIER_REJECTED:
+            return "ID_REJECTED";
+        case espMqttClientTypes::DisconnectReason::MQTT_SERVER_UNAVAILABLE:
+            return "SERVER_UNAVAILABLE";
+        case espMqttClientTypes::DisconnectReason::MQTT_MALFORMED_CREDENTIALS:
+            return "BAD_CREDENTIALS";
+        case espMqttClientTypes::DisconnectReason::MQTT_NOT_AUTHORIZED:
+            return "NOT_AUTHORIZED";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+// ============== MQTT Callbacks (Async) ==============
+
+static void onMqttConnect(bool sessionPresent) {
+    hive.handleConnect(sessionPresent);
+}
+
+static void onMqttDisconnect(espMqttClientTypes::DisconnectReason reason) {
+    hive.handleDisconnect(reason);
+}
+
+static void onMqttMessage(const espMqttClientTypes::MessageProperties& properties,
+                          const char* topic, const uint8_t* payload, size_t len,
+                          size_t index, size_t total) {
+    hive.handleMessage(topic, payload, len);
+}
+
+void HiveCore::handleConnect(bool sessionPresent) {
+    mqttLog("[MQTT] Connected! Session present: %d\n", sessionPresent);
+    _connectCount++;
+    _sessionPresent = sessionPresent;
+    _connecting = false;
+    _brokers.connected(millis() - _connectStarted);
+    if (_disconnectedAt) {
+        _lastOutage = millis() - _disconnectedAt;
+        if (_lastOutage > _longestOutage) _longestOutage = _lastOutage;
+        _disconnectedAt = 0;
+        mqttLog("[MQTT] Reconnected after %lu ms (%d attempts)\n",
+                (unsigned long)_lastOutage, _reconnectFailures);
+    }
+    if (_bootMs[HIVE_BOOT_MQTT] == 0) {
+        _bootMs[HIVE_BOOT_MQTT] = millis();
+        mqttLog("[BOOT] Online in %lu ms (wifi %lu, fast connect %s)\n",
+                (unsigned long)_bootMs[HIVE_BOOT_MQTT], (unsigned long)_bootMs[HIVE_BOOT_WIFI],
+                hiveWiFi.fastConnected() ? "yes" : "no");
+    }
+    refreshIp();
+    _mqttConnected = true;
+    _lastConnectTime = millis();
+    _lastError = "none";
+
+    // A resumed session keeps our subscription and queues QoS1 commands sent while offline
+    if (!sessionPresent) {
+        uint16_t packetId = mqttClient.subscribe(_topics.command.c_str(), 1);
+        mqttLog("[MQTT] Subscribed to %s (packet %d)\n", _topics.command.c_str(), packetId);
+        for (size_t i = 0; i < _subscriptionCount; i++) {
+            mqttClient.subscribe(_subscriptions[i].topic.c_str(), _subscriptions[i].qos);
+            mqttLog("[MQTT] Subscribed to %s\n", _subscriptions[i].topic.c_str());
+        }
+    }
+
+    // Publish online status (the broker published our LWT when we dropped)
+    mqttClient.publish(_topics.availability.c_str(), 1, true, "online");
+
+    // Discovery is retained: republish only on the first connect or when the broker
+    // lost our session (and likely its retained store); state may have moved while
+    // offline, and health restarts with a keyframe. Sent from loop(), state first.
+    _telemetry.requestKeyframe();
+    if (!_discoveryPublished || !sessionPresent) _scheduler.request(HIVE_PUB_DISCOVERY, true);
+    _scheduler.request(HIVE_PUB_STATE, true);
+    _scheduler.request(HIVE_PUB_HEALTH, true);
+
+#if HIVE_BENCH
+    hiveBench.publish();  // First connect after a benchmark run
+#endif
+
+    if (_connectHook) _connectHook(sessionPresent);
+}
+
+void HiveCore::handleDisconnect(espMqttClientTypes::DisconnectReason reason) {
+    Serial.printf("[MQTT] Disconnected! Reason: %d\n", (int)reason);
+
+    // Attempt refused or dropped before CONNACK: move on to the next broker
+    if (_connecting) connectFailed(disconnectReasonName(reason));
+
+    if (_mqttConnected) {
+        _connectionDuration = millis() - _lastConnectTime;
+        Serial.printf("[MQTT] Was connected for %lu ms\n", _connectionDuration);
+
+        // A connection that flaps right after connecting keeps backing off
+        if (_connectionDuration >= HIVE_RECONNECT_STABLE) _reconnectFailures = 0;
+
+        // The broker dropped us (not our own DISCONNECT, not a WiFi outage):
+        // hold it off so the next round tries a healthy broker first
+        if (reason != espMqttClientTypes::DisconnectReason::USER_OK && !_sleeping && WiFi.isConnected()) {
+            _brokers.failed();
+        }
+        _disconnectedAt = millis();
+        _lastOutageSample = _disconnectedAt;
+
+        // Jittered even for the first retry so bees don't stampede a restarted broker
+        scheduleReconnect();
+        _lastError = disconnectReasonName(reason);
+    }
+
+    _mqttConnected = false;
+
+    if (_disconnectHook) _disconnectHook(reason);
+}
+
+void HiveCore::handleMessage(const char* topic, const uint8_t* payload, size_t len) {
+    hiveDebug("[MQTT] Message on %s (%d bytes)\n", topic, len);
+
+    // Our topics were hashed at setup: one pass over the incoming topic,
+    // a full compare only on a hash hit
+    uint32_t hash = hiveHash(topic);
+    if (hash != _commandTopicHash || _topics.command != topic) {
+        for (size_t i = 0; i < _subscriptionCount; i++) {
+            const HiveSubscription& entry = _subscriptions[i];
+            if (entry.hash == hash && entry.topic == topic) {
+                entry.hook(topic, payload, len);
+                return;
+            }
+        }
+        // Anything else the bee subscribed itself goes to it raw
+        if (_messageHook) _messageHook(topic, payload, len);
+        return;
+    }
+
+    // Only the fields handlers read, in the RX arena instead of the heap
+    rxArena.reset();
+    JsonDocument doc(&rxArena);
+    DeserializationError error = deserializeJson(doc, payload, len, DeserializationOption::Filter(_commandFilter));
+
+    if (error) {
+        mqttLog("[MQTT] JSON parse error: %s\n", error.c_str());
+        return;
+    }
+
+    dispatchCommand(doc);
+}
+
+void HiveCore::dispatchCommand(JsonDocument& doc) {
+    if (!doc["capability"].is<JsonObject>()) return;
+
+    JsonObject capability = doc["capability"];
+    const char* instance = capability["instance"];
+    if (!instance) return;
+    uint32_t hash = hiveHash(instance);
+
+    // Link probes and duplicates of messages that already arrived over ESP-NOW
+    if (hiveLink.handleCommand(hash, capability, doc)) return;
+
+    for (size_t i = 0; i < _commandCount; i++) {
+        const HiveCommand& command = _commands[i];
+        if (command.hash == hash && strcmp(command.instance, instance) == 0) {
+            command.handler(instance, capability, doc);
+            return;
+        }
+    }
+
+    if (_commandHook) _commandHook(instance, capability, doc);
+}
+
+void HiveCore::onCommands(const HiveCommand* table, size_t count) {
+    _commands = table;
+    _commandCount = count;
+
+    // A collision would route one name to the other's handler; never in practice
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = i + 1; j < count; j++) {
+            if (table[i].hash == table[j].hash) {
+                Serial.printf("[CMD] %s and %s hash alike, %s unreachable\n", table[i].instance,
+                              table[j].instance, table[j].instance);
+            }
+        }
+    }
+}
+
+bool HiveCore::onTopic(const String& topic, HiveMessageHook hook, uint8_t qos) {
+    if (_subscriptionCount >= HIVE_MAX_TOPICS) {
+        Serial.printf("[MQTT] No slot for %s (HIVE_MAX_TOPICS)\n", topic.c_str());
+        return false;
+    }
+
+    HiveSubscription& entry = _subscriptions[_subscriptionCount++];
+    entry.topic = topic;
+    entry.hash = hiveHash(topic.c_str());
+    entry.hook = hook;
+    entry.qos = qos;
+
+    // Registered late: the session subscription happens on the next fresh connect
+    if (_mqttConnected) mqttClient.subscribe(entry.topic.c_str(), qos);
+    return true;
+}
+
+// ============== Setup ==============
+
+void HiveCore::begin(const HiveDeviceInfo& info) {
+    _info = info;
+    hivePublishInit();
+    hiveLogInit();
+    hiveOutbox.begin();
+
+    // Command parsing keeps these; bees add their own via commandFilter()
+    _commandFilter["capability"] = true;
+    _commandFilter["link_seq"] = true;
+
+    // State is retained, so an unchanged periodic republish is dropped
+    _scheduler.configure(HIVE_PUB_STATE, HIVE_STATE_MIN_INTERVAL, HIVE_STATE_INTERVAL, true);
+    _scheduler.configure(HIVE_PUB_DISCOVERY, HIVE_DISCOVERY_MIN_INTERVAL, 0, false);
+    _scheduler.configure(HIVE_PUB_HEALTH, HIVE_HEALTH_MIN_INTERVAL, HIVE_HEALTH_INTERVAL, false);
+
+    // Generate device ID
+    _deviceId = getDeviceId();
+    Serial.printf("Device ID: %s\n", _deviceId.c_str());
+}
+
+void HiveCore::refreshIp() {
+    IPAddress ip = WiFi.localIP();
+    if ((uint32_t)ip == _ipRaw) return;
+
+    _ipRaw = (uint32_t)ip;
+    snprintf(_ip, sizeof(_ip), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+}
+
+void HiveCore::buildTopics() {
+    String prefix = String(_config->topicPrefix);
+    _topics.discovery = prefix + "/discovery/" + _deviceId + "/config";
+    _topics.state = prefix + "/devices/" + _deviceId + "/state";
+    _topics.command = prefix + "/devices/" + _deviceId + "/set";
+    _commandTopicHash = hiveHash(_topics.command.c_str());
+    _topics.availability = prefix + "/devices/" + _deviceId + "/availability";
+    _topics.health = prefix + "/devices/" + _deviceId + "/health";
+    _topics.healthMsgPack = _topics.health + "/msgpack";
+    _topics.logs = prefix + "/devices/" + _deviceId + "/logs";
+    _topics.replay = prefix + "/devices/" + _deviceId + "/replay";
+}
+
+void HiveCore::markBoot(HiveBootPhase phase) {
+    if (phase >= HIVE_BOOT_PHASES || _bootMs[phase] != 0) return;
+    _bootMs[phase] = millis();
+    if (_mqttConnected) publishDiscovery();
+}
+
+void HiveCore::setTelemetryMode(HiveTelemetryMode mode) {
+    _telemetryMode = mode;
+    _telemetry.requestKeyframe();
+}
+
+String HiveCore::topicFor(const char* otherDeviceId, const char* leaf) const {
+    return String(_config->topicPrefix) + "/devices/" + otherDeviceId + "/" + leaf;
+}
+
+void HiveCore::setupMQTT(HiveConfig& config) {
+    _config = &config;
+
+    // Build MQTT topics
+    buildTopics();
+
+    // Set callbacks
+    mqttClient.onConnect(onMqttConnect);
+    mqttClient.onDisconnect(onMqttDisconnect);
+    mqttClient.onMessage(onMqttMessage);
+
+    // Brokers are tried per attempt by connectMQTT()
+    size_t brokerCount = _brokers.begin(config);
+
+    // Set credentials if provided
+    if (strlen(config.mqttUser) > 0) {
+        mqttClient.setCredentials(config.mqttUser, config.mqttPass);
+    }
+
+    mqttClient.setKeepAlive(HIVE_KEEP_ALIVE);
+
+    // Same ID every connect + clean session off: the broker keeps our
+    // subscription and queues QoS1 commands while we're offline
+    snprintf(_clientId, sizeof(_clientId), "%s-%s", _info.clientPrefix, _deviceId.c_str());
+    mqttClient.setClientId(_clientId);
+    mqttClient.setCleanSession(false);
+
+    // Set Last Will Testament
+    mqttClient.setWill(_topics.availability.c_str(), 1, true, "offline");
+
+    Serial.printf("[MQTT] Configured for %s (%d broker%s) as %s\n", config.mqttServer,
+                  (int)brokerCount, brokerCount == 1 ? "" : "s", _clientId);
+}
+
+// ============== Main Loop ==============
+
+void HiveCore::loop() {
+#if HIVE_PERF
+    hivePerf.loopTick();
+#endif
+
+    // Update state
+    _uptime = millis() / 1000;
+    _rssi = WiFi.RSSI();
+    refreshIp();
+
+    if (!_config) return;  // setupMQTT() not called yet
+
+#ifdef HIVE_NATIVE
+    // The host shim has no MQTT task: socket I/O and callbacks run here
+    mqttClient.loop();
+#endif
+
+    // A broker that accepts TCP but never CONNACKs (e.g. broken return route)
+    if (_connecting && millis() - _connectStarted > HIVE_BROKER_CONNECT_TIMEOUT) {
+        connectFailed("CONNACK_TIMEOUT");
+        mqttClient.disconnect(true);
+    }
+
+    // Reconnect MQTT if needed (non-blocking, jittered exponential backoff)
+    if (!_mqttConnected && !_connecting && !_sleeping && WiFi.isConnected()) {
+        if (millis() - _lastReconnectAttempt >= _reconnectDelay) {
+            connectMQTT();
+        }
+    }
+
+    // Companion link: received frames, ack timeouts, RTT probes
+    hiveLink.loop();
+
+    // Outage: health samples go to the outbox instead of nowhere
+    if (!_mqttConnected && _disconnectedAt && millis() - _lastOutageSample >= HIVE_OUTBOX_HEALTH_INTERVAL) {
+        _lastOutageSample = millis();
+        recordOutageHealth();
+    }
+
+    // One message per pass: scheduled state/discovery/health first, then
+    // events queued while offline, then logs
+    if (!sendDue(false) && !hiveOutbox.replay()) publishBufferedLogs();
+}
+
+// ============== Publish Scheduling ==============
+
+bool HiveCore::sendDue(bool flush) {
+    if (!_mqttConnected) return false;
+
+    unsigned long now = millis();
+    HivePublishTopic topic = _scheduler.due(now, flush);
+    if (topic == HIVE_PUB_NONE) return false;
+
+    bool forced = _scheduler.take(topic, now);
+    switch (topic) {
+        case HIVE_PUB_STATE: sendState(forced); break;
+        case HIVE_PUB_DISCOVERY: sendDiscovery(); break;
+        case HIVE_PUB_HEALTH: sendHealth(); break;
+        default: break;
+    }
+    return true;
+}
+
+void HiveCore::publishDiscovery() {
+    _scheduler.request(HIVE_PUB_DISCOVERY);
+}
+
+void HiveCore::publishState() {
+    _scheduler.request(HIVE_PUB_STATE);
+}
+
+void HiveCore::publishHealth() {
+    _scheduler.request(HIVE_PUB_HEALTH);
+}
+
+// ============== MQTT Functions ==============
+
+bool HiveCore::prepareSleep(uint32_t timeoutMs) {
+    _sleeping = true;  // loop() stops reconnecting
+    if (!_mqttConnected) return false;
+
+    // Replaces "online" until the next wake; the LWT still covers a bee that
+    // dies while awake
+    while (sendDue(true)) {}
+    publishBufferedLogs();
+    mqttClient.publish(_topics.availability.c_str(), 1, true, "sleeping");
+
+    unsigned long started = millis();
+    while (mqttClient.queueSize() > 0 && millis() - started < timeoutMs) {
+        delay(10);
+    }
+    bool flushed = mqttClient.queueSize() == 0;
+
+    // A clean DISCONNECT makes the broker drop the will instead of publishing it
+    mqttClient.disconnect();
+    while (!mqttClient.disconnected() && millis() - started < timeoutMs) {
+        delay(10);
+    }
+
+    Serial.printf("[MQTT] Sleeping (%s in %lu ms)\n", flushed ? "flushed" : "unacked messages",
+                  (unsigned long)(millis() - started));
+    return flushed;
+}
+
+// Backoff doubles per failed attempt up to HIVE_RECONNECT_MAX; the wait is
+// drawn from the upper half of it so retries from many bees spread out
+void HiveCore::scheduleReconnect() {
+    uint8_t shift = _reconnectFailures < 16 ? _reconnectFailures : 16;
+    uint32_t ceiling = (uint32_t)HIVE_RECONNECT_MIN << shift;
+    if (ceiling > HIVE_RECONNECT_MAX) ceiling = HIVE_RECONNECT_MAX;
+
+    _reconnectDelay = ceiling / 2 + esp_random() % (ceiling / 2 + 1);
+    _lastReconnectAttempt = millis();
+}
+
+void HiveCore::connectMQTT() {
+    _reconnectCount++;
+    const HiveBroker& broker = _brokers.next();
+
+    Serial.printf("[MQTT] Connecting... (attempt #%d)\n", _reconnectCount);
+    Serial.printf("[MQTT] Broker: %s:%d (rtt %d ms)\n", broker.host, broker.port, broker.rttMs);
+
+    _connecting = true;
+    _connectStarted = millis();
+    mqttClient.setServer(broker.host, broker.port);
+    mqttClient.connect();
+
+    // Connection is async - handleConnect() or connectFailed() follows
+}
+
+// Fail over to the next broker right away; back off once the whole round failed
+void HiveCore::connectFailed(const char* reason) {
+    if (!_connecting) return;
+    _connecting = false;
+    _lastError = reason;
+
+    const HiveBroker& broker = _brokers.active();
+    mqttLog("[MQTT] %s:%d failed (%s)\n", broker.host, broker.port, reason);
+    _brokers.failed();
+
+    if (_brokers.lastInRound()) {
+        scheduleReconnect();
+        if (_reconnectFailures < 255) _reconnectFailures++;
+        Serial.printf("[MQTT] All brokers failed, retry in %lu ms\n", (unsigned long)_reconnectDelay);
+    } else {
+        _reconnectDelay = 0;
+        _lastReconnectAttempt = millis();
+    }
+}
+
+void HiveCore::sendDiscovery() {
+    HiveMessage msg;
+    JsonDocument& doc = msg.doc;
+
+    doc["device_id"] = _deviceId.c_str();
+    doc["name"] = _config->deviceName;
+    doc["type"] = _info.type;
+    doc["model"] = _info.model;
+    doc["firmware_version"] = _info.firmware;
+    doc["ip_address"] = _ip;
+    doc["health_mode"] = telemetryModeName(_telemetryMode);
+
+    // Time-to-online for this boot (ms since boot; phases not reached are omitted)
+    JsonObject boot = doc["boot"].to<JsonObject>();
+    if (_bootMs[HIVE_BOOT_WIFI]) boot["wifi_ms"] = _bootMs[HIVE_BOOT_WIFI];
+    if (_bootMs[HIVE_BOOT_NTP]) boot["ntp_ms"] = _bootMs[HIVE_BOOT_NTP];
+    if (_bootMs[HIVE_BOOT_MQTT]) boot["mqtt_ms"] = _bootMs[HIVE_BOOT_MQTT];
+    boot["fast_connect"] = hiveWiFi.fastConnected();
+    boot["fast_connect_ms"] = hiveWiFi.connectMs();
+    boot["config_load_us"] = hiveConfig.loadUs();
+    if (hiveConfig.writes()) {
+        boot["config_save_us"] = hiveConfig.saveUs();
+        boot["config_writes"] = hiveConfig.writes();
+    }
+
+    // Bee adds capabilities/sensors
+    if (_discoveryHook) _discoveryHook(doc);
+
+    doc["timestamp"] = _uptime;
+
+    if (msg.publish(_topics.discovery.c_str(), 1, true)) {
+        _discoveryPublished = true;
+        mqttLog("[MQTT] Published discovery (%d bytes)\n", (int)msg.length());
+    }
+}
+
+void HiveCore::sendState(bool forced) {
+    HiveMessage msg;
+    JsonDocument& doc = msg.doc;
+
+    // Bee fields first so they lead the payload; only they count as a change
+    if (_stateHook) _stateHook(doc);
+
+    HiveHashWriter hash;
+    serializeJson(doc, hash);
+    if (!_scheduler.changed(HIVE_PUB_STATE, hash.hash, forced)) return;
+
+    doc["rssi"] = _rssi;
+    doc["uptime"] = _uptime;
+    doc["ip"] = _ip;
+    doc["timestamp"] = _uptime;
+
+    if (msg.publish(_topics.state.c_str(), 1, true)) _scheduler.sent(HIVE_PUB_STATE, hash.hash);
+}
+
+void HiveCore::sendHealth() {
+    HIVE_PERF_SCOPE("publishHealth");
+    HiveMessage msg;
+    JsonDocument& doc = msg.doc;
+    buildHealth(doc);
+
+    if (_telemetryMode == HIVE_TELEMETRY_FULL) {
+        msg.publish(_topics.health.c_str(), 0, false);
+        return;
+    }
+
+    // Delta modes: drop fields that haven't changed since the last publish
+    _telemetry.encode(doc);
+
+    if (_telemetryMode == HIVE_TELEMETRY_MSGPACK) {
+        msg.publishMsgPack(_topics.healthMsgPack.c_str(), 0, false);
+    } else {
+        msg.publish(_topics.health.c_str(), 0, false);
+    }
+}
+
+// The fields that explain an outage; the full record would not fit an outbox entry
+void HiveCore::recordOutageHealth() {
+    HiveMessage msg;
+    msg.doc["uptime"] = _uptime;
+    msg.doc["wifi_rssi"] = _rssi;
+    msg.doc["wifi_connected"] = WiFi.isConnected();
+    msg.doc["free_heap"] = ESP.getFreeHeap();
+    msg.doc["reconnect_failures"] = _reconnectFailures;
+    msg.doc["last_error"] = _lastError;
+    msg.publishEvent(_topics.health.c_str());
+}
+
+void HiveCore::buildHealth(JsonDocument& doc) {
+    doc["uptime"] = _uptime;
+    doc["wifi_rssi"] = _rssi;
+    doc["wifi_connected"] = WiFi.isConnected();
+    doc["mqtt_connected"] = _mqttConnected;
+    doc["mqtt_state"] = _mqttConnected ? "connected" : "disconnected";
+    doc["free_heap"] = ESP.getFreeHeap();
+    doc["largest_free_block"] = ESP.getMaxAllocHeap();
+    doc["ip"] = _ip;
+    doc["reconnect_count"] = _reconnectCount;
+    doc["mqtt_connects"] = _connectCount;
+    doc["mqtt_session_present"] = _sessionPresent;
+    doc["reconnect_failures"] = _reconnectFailures;
+    doc["reconnect_backoff_ms"] = _reconnectDelay;
+    doc["last_outage_ms"] = _lastOutage;
+    doc["longest_outage_ms"] = _longestOutage;
+    doc["last_error"] = _lastError;
+
+    const HiveBroker& broker = _brokers.active();
+    doc["mqtt_broker"] = broker.host;
+    doc["mqtt_broker_port"] = broker.port;
+    doc["mqtt_broker_rtt_ms"] = broker.rttMs;
+    doc["mqtt_connack_ms"] = _brokers.connackMs();
+    if (_brokers.count() > 1) {
+        doc["mqtt_failovers"] = _brokers.failovers();
+        JsonArray brokers = doc["mqtt_brokers"].to<JsonArray>();
+        for (size_t i = 0; i < _brokers.count(); i++) {
+            const HiveBroker& entry = _brokers.at(i);
+            JsonObject item = brokers.add<JsonObject>();
+            item["host"] = entry.host;
+            item["port"] = entry.port;
+            item["rtt_ms"] = entry.rttMs;
+            item["failures"] = entry.failures;
+        }
+    }
+
+    // Bee-specific health fields
+    if (_healthHook) _healthHook(doc);
+
+    doc["timestamp"] = millis();
+    doc["client_id"] = _clientId;
+    doc["firmware"] = _info.firmware;
+    doc["last_connect_duration_ms"] = _connectionDuration;
+    doc["time_since_connect_ms"] = _lastConnectTime > 0 ? millis() - _lastConnectTime : 0;
+
+    // Publish path stats (tune HIVE_TX_BUFFER_SIZE / HIVE_JSON_ARENA_SIZE)
+    HivePublishStats tx = hivePublishStats();
+    doc["tx_overflows"] = tx.overflows;
+    doc["tx_largest_payload"] = tx.largestPayload;
+    doc["tx_arena_peak"] = tx.arenaHighWater;
+    doc["tx_heap_fallbacks"] = tx.heapFallbacks;
+
+    // Scheduler: marks merged into a pending publish, unchanged state dropped
+    HiveScheduleStats pub = _scheduler.stats();
+    doc["pub_coalesced"] = pub.coalesced;
+    doc["pub_skipped"] = pub.skipped;
+
+    HiveLogStats logs = hiveLogStats();
+    doc["log_dropped"] = logs.dropped;
+    doc["log_queued"] = logs.queued;
+
+    HiveOutboxStats outbox = hiveOutbox.stats();
+    doc["outbox_queued"] = outbox.queued;
+    doc["outbox_dropped"] = outbox.dropped;
+    doc["outbox_replayed"] = outbox.replayed;
+
+    // Companion link (compare link_rtt_us with link_mqtt_rtt_us)
+    if (hiveLink.started()) {
+        const HiveLinkStats& link = hiveLink.stats();
+        doc["link_up"] = hiveLink.up();
+        doc["link_sent"] = link.sent;
+        doc["link_acked"] = link.acked;
+        doc["link_fallbacks"] = link.fallbacks;
+        doc["link_received"] = link.received;
+        doc["link_duplicates"] = link.duplicates;
+        doc["link_rtt_us"] = link.rttUs;
+        doc["link_rtt_avg_us"] = link.rttAvgUs;
+        doc["link_mqtt_rtt_us"] = link.mqttRttUs;
+    }
+
+#if HIVE_PERF && HIVE_PERF_HEALTH
+    // Last complete profiling window (full report on /api/perf)
+    hivePerf.healthJson(doc["perf"].to<JsonObject>());
+#endif
+}
@@ -0,0 +1,276 @@
+/**
+ * Hive Core - Shared Bee Stack
+ *
+ * Core functionality that ALL bees share, in one place:
+ * - Device ID from eFuse MAC
+ * - MQTT topics, connect/reconnect and LWT availability (espMqttClient)
+ * - Persistent MQTT session (stable client ID, clean session off) with
+ *   jittered exponential reconnect backoff
+ * - Ordered broker list with RTT-based selection and failover (HiveBroker.h)
+ * - ESP-NOW companion link with MQTT fallback (HiveLink.h)
+ * - Clean "sleeping" disconnect for deep-sleep duty-cycled bees
+ * - Discovery/State/Health publishing, coalesced and rate-limited per
+ *   topic by a priority scheduler (HiveSchedule.h)
+ * - MQTT logging with buffered publishing (HiveLog.h)
+ * - Offline store-and-forward of events with batched replay (HiveOutbox.h)
+ * - Heap-free JSON publishing (HivePublish.h)
+ * - Opt-in delta/MessagePack health telemetry (HiveTelemetry.h)
+ * - Background battery ADC sampling (HiveBattery.h)
+ * - Fast WiFi reconnect from the cached BSSID/channel (HiveWiFi.h)
+ * - Compile-time hashed command tables, filtered command parsing (HiveCommand.h)
+ * - Opt-in loop/subsystem profiling (HivePerf.h) and benchmarks (HiveBench.h)
+ * - Core config storage as one versioned, CRC-checked blob (HiveConfig.h)
+ * - Gzipped static web pages + /api/status helpers (HiveWeb.h, included
+ *   separately by bees that run ESPAsyncWebServer)
+ *
+ * Bees add their own fields and commands by registering hooks, the same
+ * way they register callbacks with espMqttClient:
+ *
+ *   hive.onState([](JsonDocument& doc) { doc["powerSwitch"] = state.ledOn; });
+ *   hive.onCommands(commands);   // {"powerSwitch", onPowerSwitch}, ...
+ *
+ * Typical setup():
+ *   hive.begin(beeInfo);      // device ID (before WiFi/config)
+ *   loadConfig();             // hiveConfig.load(): one NVS blob (HiveConfig.h)
+ *   if (!hiveWiFi.fastConnect()) wifiManager.autoConnect(...);
+ *   hiveWiFi.remember();
+ *   hive.setupMQTT(config);   // topics + MQTT, connects from hive.loop()
+ *
+ * and loop() calls hive.loop(). Boot phases (WiFi, NTP, first MQTT
+ * connect) are timed with markBoot() and published under "boot" in
+ * discovery to track time-to-online across the fleet.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <espMqttClient.h>
+#include <ArduinoJson.h>
+
+#include "HivePlatform.h"
+#include "HiveConfig.h"
+#include "HiveLog.h"
+#include "HivePublish.h"
+#include "HiveTelemetry.h"
+#include "HiveBattery.h"
+#include "HiveWiFi.h"
+#include "HiveBroker.h"
+#include "HiveCommand.h"
+#include "HiveLink.h"
+#include "HivePerf.h"
+#include "HiveBench.h"
+#include "HiveSchedule.h"
+#include "HiveOutbox.h"
+
+#ifndef HIVE_RECONNECT_MIN
+#define HIVE_RECONNECT_MIN 1000          // First reconnect backoff (doubles per failure)
+#endif
+#ifndef HIVE_RECONNECT_MAX
+#define HIVE_RECONNECT_MAX 60000         // Backoff ceiling
+#endif
+#ifndef HIVE_RECONNECT_STABLE
+#define HIVE_RECONNECT_STABLE 30000      // Connected this long resets the backoff
+#endif
+#define HIVE_HEALTH_INTERVAL 5000        // Publish health every 5 seconds
+#define HIVE_STATE_INTERVAL 30000        // Republish state every 30 seconds (if changed)
+#ifndef HIVE_KEEP_ALIVE
+#define HIVE_KEEP_ALIVE 15               // MQTT keep-alive (seconds); bounds dead-broker detection
+#endif
+#ifndef HIVE_SLEEP_FLUSH_TIMEOUT
+#define HIVE_SLEEP_FLUSH_TIMEOUT 3000    // Max wait for QoS1 acks + DISCONNECT before deep sleep
+#endif
+
+// Static description of a bee, filled in once by each firmware
+struct HiveDeviceInfo {
+    const char* type;          // DEVICE_TYPE (e.g. "esp32-c3")
+    const char* model;         // Shown in discovery (e.g. "ESP32-C3 Mission Control")
+    const char* firmware;      // FIRMWARE_VERSION
+    const char* clientPrefix;  // MQTT client ID prefix (e.g. "esp32c3")
+};
+
+// Boot milestones, recorded as ms since boot by hive.markBoot()
+enum HiveBootPhase : uint8_t {
+    HIVE_BOOT_WIFI = 0,   // hiveWiFi.remember()
+    HIVE_BOOT_NTP,        // Bees with a clock
+    HIVE_BOOT_MQTT,       // First MQTT connect (automatic)
+    HIVE_BOOT_PHASES
+};
+
+struct HiveTopics {
+    String discovery;
+    String state;
+    String command;
+    String availability;
+    String health;
+    String healthMsgPack;  // HIVE_TELEMETRY_MSGPACK only
+    String logs;
+    String replay;         // Events queued while offline (HiveOutbox.h)
+};
+
+// Bee hooks
+typedef void (*HiveConnectHook)(bool sessionPresent);
+typedef void (*HiveDisconnectHook)(espMqttClientTypes::DisconnectReason reason);
+typedef void (*HiveMessageHook)(const char* topic, const uint8_t* payload, size_t len);
+typedef void (*HiveJsonHook)(JsonDocument& doc);
+
+// Extra topic registered with hive.onTopic(); hashed once when registered
+struct HiveSubscription {
+    String topic;
+    uint32_t hash;
+    HiveMessageHook hook;
+    uint8_t qos;
+};
+
+class HiveCore {
+public:
+    void begin(const HiveDeviceInfo& info);
+    void setupMQTT(HiveConfig& config);
+    void loop();
+
+    void connectMQTT();
+
+    // Mark the topic dirty; hive.loop() sends it (HiveSchedule.h). Safe from
+    // any task, and cheap enough to call on every change.
+    void publishDiscovery();
+    void publishState();
+    void publishHealth();
+
+    // Full health record (before delta encoding), as publishHealth() sends it
+    void buildHealth(JsonDocument& doc);
+
+    // Hooks (all optional)
+    void onConnect(HiveConnectHook hook) { _connectHook = hook; }
+    void onDisconnect(HiveDisconnectHook hook) { _disconnectHook = hook; }
+    void onCommand(HiveCommandHook hook) { _commandHook = hook; }  // Instances not in the table
+    void onMessage(HiveMessageHook hook) { _messageHook = hook; }
+    void onDiscovery(HiveJsonHook hook) { _discoveryHook = hook; }
+    void onState(HiveJsonHook hook) { _stateHook = hook; }
+    void onHealth(HiveJsonHook hook) { _healthHook = hook; }
+
+    // Capability table (HiveCommand.h); must outlive the bee, i.e. static
+    template <size_t N>
+    void onCommands(const HiveCommand (&table)[N]) { onCommands(table, N); }
+    void onCommands(const HiveCommand* table, size_t count);
+
+    // Extra subscription with its own handler (e.g. a companion's availability),
+    // subscribed with the command topic; false when HIVE_MAX_TOPICS are taken
+    bool onTopic(const String& topic, HiveMessageHook hook, uint8_t qos = 1);
+
+    // Top-level fields kept when parsing set-topic payloads (HiveCommand.h)
+    JsonDocument& commandFilter() { return _commandFilter; }
+
+    // Health encoding (see HiveTelemetry.h); forces a keyframe on change
+    void setTelemetryMode(HiveTelemetryMode mode);
+    HiveTelemetryMode telemetryMode() const { return _telemetryMode; }
+
+    // First call per phase wins; safe from other tasks (e.g. the SNTP callback).
+    // Phases reached after discovery went out trigger a republish.
+    void markBoot(HiveBootPhase phase);
+    uint32_t bootMs(HiveBootPhase phase) const { return _bootMs[phase]; }
+
+    // Duty-cycled bees call this right before esp_deep_sleep_start(): publishes
+    // retained "sleeping" availability, waits for the outbox to drain and
+    // disconnects cleanly, so the broker discards our "offline" LWT. False if
+    // anything was still unacked at timeout. No reconnects afterwards.
+    // Pending state/health go out first.
+    bool prepareSleep(uint32_t timeoutMs = HIVE_SLEEP_FLUSH_TIMEOUT);
+
+    // Topic for another device, e.g. topicFor(companionId, "availability")
+    String topicFor(const char* otherDeviceId, const char* leaf) const;
+
+    // Status
+    const String& deviceId() const { return _deviceId; }
+    const HiveTopics& topics() const { return _topics; }
+    const HiveDeviceInfo& info() const { return _info; }
+    bool mqttConnected() const { return _mqttConnected; }
+    unsigned long uptime() const { return _uptime; }
+    int rssi() const { return _rssi; }
+    int reconnectCount() const { return _reconnectCount; }
+    uint32_t connectCount() const { return _connectCount; }
+    const char* lastError() const { return _lastError; }
+    const char* clientId() const { return _clientId; }
+    const HiveBrokers& brokers() const { return _brokers; }
+    const char* ip() const { return _ip; }  // Cached dotted quad, refreshed by loop()
+    HiveScheduleStats publishStats() const { return _scheduler.stats(); }
+
+    // Called from the espMqttClient callbacks in HiveCore.cpp
+    void handleConnect(bool sessionPresent);
+    void handleDisconnect(espMqttClientTypes::DisconnectReason reason);
+    void handleMessage(const char* topic, const uint8_t* payload, size_t len);
+
+    // {"capability":{"instance":...}} from MQTT or the companion link -> onCommand
+    void dispatchCommand(JsonDocument& doc);
+
+private:
+    void buildTopics();
+    void refreshIp();
+    void scheduleReconnect();
+    void connectFailed(const char* reason);
+    bool sendDue(bool flush);
+    void sendDiscovery();
+    void sendState(bool forced);
+    void sendHealth();
+    void recordOutageHealth();
+
+    HiveDeviceInfo _info = {"esp32", "ESP32", "0.0.0", "esp32"};
+    HiveConfig* _config = nullptr;
+    String _deviceId;
+    HiveTopics _topics;
+
+    // Connection tracking
+    bool _mqttConnected = false;
+    unsigned long _uptime = 0;
+    int _rssi = 0;
+    int _reconnectCount = 0;          // Connect attempts since boot
+    uint32_t _connectCount = 0;       // Successful connects since boot
+    uint8_t _reconnectFailures = 0;   // Attempts since the last stable connection
+    uint32_t _reconnectDelay = 0;     // Current jittered backoff (0 = connect now)
+    unsigned long _disconnectedAt = 0;
+    unsigned long _lastOutageSample = 0;  // Health queued for replay during an outage
+    uint32_t _lastOutage = 0;         // Disconnect to reconnect, ms
+    uint32_t _longestOutage = 0;
+    bool _sessionPresent = false;
+    volatile bool _connecting = false;   // CONNECT sent, waiting for CONNACK
+    unsigned long _connectStarted = 0;
+    bool _discoveryPublished = false;
+    bool _sleeping = false;           // prepareSleep() ran; stay disconnected
+    const char* _lastError = "none";
+    unsigned long _lastConnectTime = 0;
+    unsigned long _connectionDuration = 0;
+    char _clientId[64] = "";          // Stable per device so the broker resumes the session
+
+    // Precomputed so publishes don't call WiFi.localIP().toString()
+    char _ip[16] = "0.0.0.0";
+    uint32_t _ipRaw = 0;
+
+    volatile uint32_t _bootMs[HIVE_BOOT_PHASES] = {};
+
+    HiveTelemetryMode _telemetryMode = (HiveTelemetryMode)HIVE_TELEMETRY_MODE;
+    HiveTelemetry _telemetry;
+    HiveBrokers _brokers;
+    HiveScheduler _scheduler;
+
+    // Timers for non-blocking periodic tasks
+    unsigned long _lastReconnectAttempt = 0;
+
+    HiveConnectHook _connectHook = nullptr;
+    HiveDisconnectHook _disconnectHook = nullptr;
+    HiveCommandHook _commandHook = nullptr;
+    const HiveCommand* _commands = nullptr;
+    size_t _commandCount = 0;
+    JsonDocument _commandFilter;
+    uint32_t _commandTopicHash = 0;
+    HiveSubscription _subscriptions[HIVE_MAX_TOPICS];
+    size_t _subscriptionCount = 0;
+    HiveMessageHook _messageHook = nullptr;
+    HiveJsonHook _discoveryHook = nullptr;
+    HiveJsonHook _stateHook = nullptr;
+    HiveJsonHook _healthHook = nullptr;
+};
+
+extern HIVE_PER_BEE HiveCore hive;
+extern HIVE_PER_BEE espMqttClient mqttClient;
+
+String getDeviceId();
+const char* disconnectReasonName(espMqttClientTypes::DisconnectReason reason);
@@ -0,0 +1,353 @@
+/**
+ * Hive Core - Companion Link (ESP-NOW)
+ */
+
+#include "HiveLink.h"
+#include "HiveCore.h"
+
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include <esp_random.h>
+
+#define HIVE_LINK_MAGIC 0xB8  // 0xB7 frames had no epoch
+
+enum HiveLinkKind : uint8_t {
+    HIVE_LINK_MSG = 1,   // MessagePack capability document
+    HIVE_LINK_ACK = 2,   // Echoes the seq of a MSG or PING
+    HIVE_LINK_PING = 3   // No payload, just an ack (probe / RTT)
+};
+
+struct __attribute__((packed)) HiveLinkHeader {
+    uint8_t magic;
+    uint8_t kind;
+    uint16_t epoch;  // Sender's boot; acks echo the original sender's
+    uint16_t seq;
+};
+
+struct HiveLinkFrame {
+    uint8_t len;
+    uint8_t data[ESP_NOW_MAX_DATA_LEN];
+};
+
+HIVE_PER_BEE HiveLink hiveLink;
+
+// Shared with the receive callback (WiFi task)
+static HIVE_PER_BEE QueueHandle_t linkRx = nullptr;
+static HIVE_PER_BEE uint8_t linkPeer[6];
+
+// send() runs on whichever task the bee calls it from, loop() on the task
+// running hive.loop() and handleCommand() on the MQTT task
+static HIVE_PER_BEE portMUX_TYPE linkMux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline uint32_t linkSeq(uint16_t epoch, uint16_t seq) {
+    return ((uint32_t)epoch << 16) | seq;
+}
+
+// Device IDs print the efuse MAC as a little-endian integer, so the
+// hex bytes come out in reverse order (see getDeviceId())
+static bool macFromDeviceId(const char* id, uint8_t* mac) {
+    if (strlen(id) != 12) return false;
+    for (int i = 0; i < 6; i++) {
+        char hex[3] = {id[i * 2], id[i * 2 + 1], '\0'};
+        char* end = nullptr;
+        long value = strtol(hex, &end, 16);
+        if (*end != '\0') return false;
+        mac[5 - i] = (uint8_t)value;
+    }
+    return true;
+}
+
+// Runs on the WiFi task: only frames from our companion, handled in loop()
+static void onLinkRecv(const esp_now_recv_info_t* info, const uint8_t* data, int len) {
+    if (len < (int)sizeof(HiveLinkHeader) || len > ESP_NOW_MAX_DATA_LEN) return;
+    if (memcmp(info->src_addr, linkPeer, sizeof(linkPeer)) != 0) return;
+
+    HiveLinkFrame frame;
+    frame.len = len;
+    memcpy(frame.data, data, len);
+    xQueueSend(linkRx, &frame, 0);
+}
+
+// ============== Setup ==============
+
+bool HiveLink::begin(const char* companionId) {
+    if (_started) return true;
+    if (!companionId || !macFromDeviceId(companionId, linkPeer)) {
+        mqttLog("[LINK] Invalid companion ID, MQTT only\n");
+        return false;
+    }
+
+    // Fallback path works even if ESP-NOW doesn't come up
+    _companionSet = hive.topicFor(companionId, "set");
+    _epoch = (uint16_t)esp_random();
+
+    if (esp_now_init() != ESP_OK) {
+        mqttLog("[LINK] ESP-NOW init failed, MQTT only\n");
+        return false;
+    }
+
+    linkRx = xQueueCreate(HIVE_LINK_RX_QUEUE, sizeof(HiveLinkFrame));
+    esp_now_register_recv_cb(onLinkRecv);
+
+    esp_now_peer_info_t peer = {};
+    memcpy(peer.peer_addr, linkPeer, sizeof(linkPeer));
+    peer.channel = 0;  // Whatever channel the AP put us on
+    peer.ifidx = WIFI_IF_STA;
+    peer.encrypt = false;
+    if (esp_now_add_peer(&peer) != ESP_OK) {
+        mqttLog("[LINK] Failed to add companion peer, MQTT only\n");
+        return false;
+    }
+
+    _started = true;
+    mqttLog("[LINK] ESP-NOW link to %s (%02x:%02x:%02x:%02x:%02x:%02x)\n", companionId,
+            linkPeer[0], linkPeer[1], linkPeer[2], linkPeer[3], linkPeer[4], linkPeer[5]);
+
+    probe();  // The companion's ack brings the link up
+    return true;
+}
+
+// ============== Send ==============
+
+void HiveLink::send(HiveMessage& msg) {
+    portENTER_CRITICAL(&linkMux);
+    uint16_t seq = ++_seq;
+    bool direct = _started && _up && !_pending;
+    portEXIT_CRITICAL(&linkMux);
+    msg.doc["link_seq"] = linkSeq(_epoch, seq);
+
+    // Link down or busy with another message: straight to the broker
+    if (direct) {
+        uint8_t payload[sizeof(_pendingData)];
+        size_t len = serializeMsgPack(msg.doc, payload, sizeof(payload));
+        if (len > 0 && len < sizeof(payload)) {
+            // Another task may have taken the slot since we looked
+            portENTER_CRITICAL(&linkMux);
+            bool claimed = !_pending;
+            if (claimed) {
+                _pending = true;
+                _pendingIsPing = false;
+                _pendingSeq = seq;
+                _pendingLen = len;
+                memcpy(_pendingData, payload, len);
+                _pendingUs = micros();
+            }
+            portEXIT_CRITICAL(&linkMux);
+
+            if (claimed) {
+                sendFrame(HIVE_LINK_MSG, _epoch, seq, payload, len);
+                return;
+            }
+        }
+    }
+
+    if (_companionSet.length() > 0 && msg.publish(_companionSet.c_str(), 0, false)) {
+        portENTER_CRITICAL(&linkMux);
+        _stats.fallbacks++;
+        portEXIT_CRITICAL(&linkMux);
+    } else {
+        mqttLog("[LINK] Message %u dropped (no link, MQTT down)\n", seq);
+    }
+}
+
+void HiveLink::sendFrame(uint8_t kind, uint16_t epoch, uint16_t seq, const uint8_t* payload, size_t len) {
+    uint8_t frame[ESP_NOW_MAX_DATA_LEN];
+    HiveLinkHeader header = {HIVE_LINK_MAGIC, kind, epoch, seq};
+    memcpy(frame, &header, sizeof(header));
+    if (len > 0) memcpy(frame + sizeof(header), payload, len);
+
+    esp_now_send(linkPeer, frame, sizeof(header) + len);
+    if (kind != HIVE_LINK_ACK) {
+        portENTER_CRITICAL(&linkMux);
+        _stats.sent++;
+        portEXIT_CRITICAL(&linkMux);
+    }
+}
+
+// ============== Loop ==============
+
+void HiveLink::loop() {
+    if (!_started) return;
+
+    HiveLinkFrame frame;
+    while (xQueueReceive(linkRx, &frame, 0) == pdTRUE) {
+        handleFrame(frame.data, frame.len);
+    }
+
+    checkAck();
+
+    if (millis() - _lastProbe >= HIVE_LINK_PROBE_INTERVAL) {
+        probe();
+    }
+}
+
+void HiveLink::handleFrame(const uint8_t* data, size_t len) {
+    HiveLinkHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != HIVE_LINK_MAGIC) return;
+
+    if (header.kind == HIVE_LINK_ACK) {
+        acked(header.epoch, header.seq);
+        return;
+    }
+
+    // Anything else from the companion proves it can hear us too
+    sendFrame(HIVE_LINK_ACK, header.epoch, header.seq, nullptr, 0);
+
+    portENTER_CRITICAL(&linkMux);
+    bool cameUp = !_up;
+    _up = true;
+    if (cameUp) _misses = 0;
+    bool message = header.kind == HIVE_LINK_MSG;
+    if (message) {
+        _lastRxSeq = linkSeq(header.epoch, header.seq);
+        _rxSeen = true;
+        _stats.received++;
+    }
+    portEXIT_CRITICAL(&linkMux);
+
+    if (cameUp) mqttLog("[LINK] Companion reachable over ESP-NOW\n");
+    if (!message) return;
+
+    JsonDocument doc;
+    DeserializationError error = deserializeMsgPack(doc, data + sizeof(header), len - sizeof(header),
+                                                    DeserializationOption::Filter(hive.commandFilter()));
+    if (error) {
+        mqttLog("[LINK] Bad frame %u: %s\n", header.seq, error.c_str());
+        return;
+    }
+
+    // Same path as a command on our MQTT set topic; link_seq is only for
+    // spotting the MQTT copy of a message we already have
+    doc.remove("link_seq");
+    hive.dispatchCommand(doc);
+}
+
+void HiveLink::acked(uint16_t epoch, uint16_t seq) {
+    portENTER_CRITICAL(&linkMux);
+    bool ours = _pending && epoch == _epoch && seq == _pendingSeq;
+    uint32_t rtt = micros() - _pendingUs;
+    bool cameUp = false;
+    if (ours) {
+        _pending = false;
+        _stats.acked++;
+        _stats.rttUs = rtt;
+        _stats.rttAvgUs = (uint32_t)(((uint64_t)_stats.rttAvgUs * (_stats.acked - 1) + rtt) / _stats.acked);
+        _misses = 0;
+        cameUp = !_up;
+        _up = true;
+    }
+    portEXIT_CRITICAL(&linkMux);
+
+    if (cameUp) mqttLog("[LINK] Companion reachable over ESP-NOW (%lu us)\n", (unsigned long)rtt);
+}
+
+// Ack timeout: the slot is released and its message copied out under the
+// lock, so a send() on another task can't reuse it mid-fallback
+void HiveLink::checkAck() {
+    uint8_t data[sizeof(_pendingData)];
+    size_t len = 0;
+    uint16_t seq = 0;
+    bool wentDown = false;
+
+    portENTER_CRITICAL(&linkMux);
+    bool expired = _pending && micros() - _pendingUs > HIVE_LINK_ACK_TIMEOUT * 1000UL;
+    if (expired) {
+        _pending = false;
+        if (!_pendingIsPing) {
+            len = _pendingLen;
+            seq = _pendingSeq;
+            memcpy(data, _pendingData, len);
+        }
+        if (_misses < 255) _misses++;
+        wentDown = _up && _misses >= HIVE_LINK_MAX_MISSES;
+        if (wentDown) _up = false;
+    }
+    portEXIT_CRITICAL(&linkMux);
+
+    if (len > 0) fallback(data, len, seq);
+    if (wentDown) mqttLog("[LINK] Companion not answering, using MQTT\n");
+}
+
+// Replays the unacked message on the companion's MQTT set topic
+void HiveLink::fallback(const uint8_t* data, size_t len, uint16_t seq) {
+    HiveMessage msg;
+    if (deserializeMsgPack(msg.doc, data, len) ||
+        !msg.publish(_companionSet.c_str(), 0, false)) {
+        mqttLog("[LINK] Message %u lost (no ack, MQTT down)\n", seq);
+        return;
+    }
+    portENTER_CRITICAL(&linkMux);
+    _stats.fallbacks++;
+    portEXIT_CRITICAL(&linkMux);
+}
+
+// Pings both paths: ESP-NOW (acked by the companion's link) and MQTT
+// (answered with linkPong by the companion's hive core)
+void HiveLink::probe() {
+    _lastProbe = millis();
+
+    portENTER_CRITICAL(&linkMux);
+    bool ping = !_pending;
+    uint16_t seq = 0;
+    if (ping) {
+        _pending = true;
+        _pendingIsPing = true;
+        seq = _pendingSeq = ++_seq;
+        _pendingUs = micros();
+    }
+    portEXIT_CRITICAL(&linkMux);
+    if (ping) sendFrame(HIVE_LINK_PING, _epoch, seq, nullptr, 0);
+
+    if (hive.mqttConnected()) {
+        HiveMessage msg;
+        JsonObject capability = msg.doc["capability"].to<JsonObject>();
+        capability["instance"] = "linkPing";
+        capability["seq"] = ++_mqttPingSeq;
+        capability["from"] = hive.deviceId().c_str();
+        _mqttPingUs = micros();
+        msg.publish(_companionSet.c_str(), 0, false);
+    }
+}
+
+// ============== MQTT Side ==============
+
+bool HiveLink::handleCommand(uint32_t instanceHash, JsonObject capability, JsonDocument& doc) {
+    if (instanceHash == hiveHash("linkPing")) {
+        const char* from = capability["from"];
+        if (from && strlen(from) == 12) {
+            HiveMessage pong;
+            JsonObject reply = pong.doc["capability"].to<JsonObject>();
+            reply["instance"] = "linkPong";
+            reply["seq"] = capability["seq"];
+            pong.publish(hive.topicFor(from, "set").c_str(), 0, false);
+        }
+        return true;
+    }
+
+    if (instanceHash == hiveHash("linkPong")) {
+        if (_mqttPingUs != 0 && (uint16_t)(capability["seq"] | 0) == _mqttPingSeq) {
+            _stats.mqttRttUs = micros() - _mqttPingUs;
+            _mqttPingUs = 0;
+        }
+        return true;
+    }
+
+    // MQTT copy of a message the link already delivered (its ack got lost)
+    if (doc["link_seq"].is<uint32_t>()) return duplicate(doc["link_seq"]);
+    return false;
+}
+
+// Epoch in the high half: a rebooted companion restarting at seq 1 never matches
+bool HiveLink::duplicate(uint32_t linkSeq) {
+    portENTER_CRITICAL(&linkMux);
+    bool seen = _rxSeen && linkSeq == _lastRxSeq;
+    if (seen) {
+        _stats.duplicates++;
+    } else {
+        _lastRxSeq = linkSeq;
+        _rxSeen = true;
+    }
+    portEXIT_CRITICAL(&linkMux);
+    return seen;
+}
@@ -0,0 +1,123 @@
+/**
+ * Hive Core - Companion Link (ESP-NOW)
+ *
+ * Direct bee-to-bee path for capability messages, so a button on one bee
+ * reaches its companion in a few ms without the broker round trip:
+ *
+ *   hiveLink.begin(config.companionBeeId);   // after hive.setupMQTT()
+ *
+ *   HiveMessage msg;
+ *   msg.doc["capability"]["instance"] = "loveMessage";
+ *   msg.doc["capability"]["type"] = 2;
+ *   hiveLink.send(msg);
+ *
+ * The document goes out as MessagePack behind a 6-byte header; the
+ * companion acks it and hands it to its onCommand hook exactly as if it
+ * had arrived on its MQTT set topic. Without an ack within
+ * HIVE_LINK_ACK_TIMEOUT the same message is published to the companion's
+ * set topic instead (link_seq lets the receiver drop duplicates; it carries
+ * a per-boot epoch with the sequence, so a rebooted companion counting from
+ * 1 again is never mistaken for a duplicate). After
+ * HIVE_LINK_MAX_MISSES misses in a row the link is considered down and
+ * sends go straight to MQTT until a probe is acked again.
+ *
+ * The companion's MAC is derived from its device ID (the efuse MAC), and
+ * both bees must be on the same AP/channel. Every HIVE_LINK_PROBE_INTERVAL
+ * both paths are pinged, and the round trips show up in health as
+ * link_rtt_us and link_mqtt_rtt_us.
+ *
+ * send() is safe from any task (e.g. kaycibee's UI side while hive.loop()
+ * runs on the network task); the in-flight slot, sequence and duplicate
+ * state are kept under one lock.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "HivePlatform.h"
+
+class HiveMessage;
+
+#ifndef HIVE_LINK_ACK_TIMEOUT
+#define HIVE_LINK_ACK_TIMEOUT 50            // ms before falling back to MQTT
+#endif
+
+#ifndef HIVE_LINK_MAX_MISSES
+#define HIVE_LINK_MAX_MISSES 3              // Unacked sends before the link is down
+#endif
+
+#ifndef HIVE_LINK_PROBE_INTERVAL
+#define HIVE_LINK_PROBE_INTERVAL 60000      // Ping both paths to compare RTT
+#endif
+
+#ifndef HIVE_LINK_RX_QUEUE
+#define HIVE_LINK_RX_QUEUE 4                // Frames buffered between WiFi task and loop
+#endif
+
+struct HiveLinkStats {
+    uint32_t sent;          // Frames sent over ESP-NOW
+    uint32_t acked;
+    uint32_t fallbacks;     // Messages that went over MQTT instead
+    uint32_t received;      // Messages delivered to us over ESP-NOW
+    uint32_t duplicates;    // MQTT fallbacks dropped because ESP-NOW got there first
+    uint32_t rttUs;         // Last ESP-NOW round trip
+    uint32_t rttAvgUs;      // Mean over all acked frames
+    uint32_t mqttRttUs;     // Last linkPing/linkPong round trip through the broker
+};
+
+class HiveLink {
+public:
+    bool begin(const char* companionId);
+
+    // Send a capability message to the companion (consumes msg); any task
+    void send(HiveMessage& msg);
+
+    // Called from hive.loop(): received frames, ack timeouts, probes
+    void loop();
+
+    // HiveCore hands every command here first; true if it was link traffic
+    // (linkPing/linkPong or a duplicate of a message already delivered)
+    bool handleCommand(uint32_t instanceHash, JsonObject capability, JsonDocument& doc);
+
+    bool started() const { return _started; }
+    bool up() const { return _up; }
+    const HiveLinkStats& stats() const { return _stats; }
+
+private:
+    void sendFrame(uint8_t kind, uint16_t epoch, uint16_t seq, const uint8_t* payload, size_t len);
+    void handleFrame(const uint8_t* data, size_t len);
+    void acked(uint16_t epoch, uint16_t seq);
+    void checkAck();
+    void fallback(const uint8_t* data, size_t len, uint16_t seq);
+    void probe();
+    bool duplicate(uint32_t linkSeq);
+
+    bool _started = false;
+    bool _up = false;
+    String _companionSet;  // Companion's MQTT set topic (fallback path)
+
+    uint16_t _epoch = 0;   // Random per boot; high half of link_seq
+    uint16_t _seq = 0;
+    uint8_t _misses = 0;
+
+    // One message in flight; kept for the MQTT fallback until acked
+    bool _pending = false;
+    uint16_t _pendingSeq = 0;
+    bool _pendingIsPing = false;
+    uint32_t _pendingUs = 0;
+    uint8_t _pendingData[240];
+    size_t _pendingLen = 0;
+
+    uint32_t _lastRxSeq = 0;   // Companion's epoch << 16 | seq
+    bool _rxSeen = false;
+
+    uint16_t _mqttPingSeq = 0;
+    uint32_t _mqttPingUs = 0;
+    unsigned long _lastProbe = 0;
+
+    HiveLinkStats _stats = {};
+};
+
+extern HIVE_PER_BEE HiveLink hiveLink;
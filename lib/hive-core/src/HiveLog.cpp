@@ -0,0 +1,146 @@
+/**
+ * Hive Core - MQTT Logging
+ */
+
+#include "HiveLog.h"
+#include "HiveCore.h"
+
+#include <stdarg.h>
+#include <esp_heap_caps.h>
+
+// ============== Log Ring ==============
+
+struct LogEntry {
+    uint32_t ts;  // Uptime (seconds) when the line was logged
+    char msg[HIVE_LOG_MSG_SIZE];
+};
+
+// mqttLog() runs on both loop() and the MQTT task; only the ring indices
+// are shared, queued entries are never overwritten while being published
+static HIVE_PER_BEE portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+
+static HIVE_PER_BEE LogEntry* logRing = nullptr;
+static HIVE_PER_BEE size_t logCapacity = 0;
+static HIVE_PER_BEE size_t logHead = 0;   // Next slot to write
+static HIVE_PER_BEE size_t logCount = 0;  // Queued entries ending at logHead
+static HIVE_PER_BEE uint32_t logDropped = 0;
+static HIVE_PER_BEE unsigned long lastLogPublish = 0;
+
+void hiveLogInit() {
+    if (logRing) return;
+
+    size_t capacity = HIVE_LOG_BUFFER_SIZE;
+#ifdef BOARD_HAS_PSRAM
+    logRing = (LogEntry*)heap_caps_malloc(capacity * sizeof(LogEntry), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#endif
+    if (!logRing) {
+        if (capacity > HIVE_LOG_INTERNAL_MAX) capacity = HIVE_LOG_INTERNAL_MAX;
+        logRing = (LogEntry*)malloc(capacity * sizeof(LogEntry));
+    }
+    logCapacity = logRing ? capacity : 0;
+}
+
+// Upper bound on the serialized size of one {"ts":..,"msg":".."} entry
+static size_t entryCost(const char* text) {
+    size_t cost = 24;  // {"ts":4294967,"msg":""},
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') cost += 2;
+        else if ((uint8_t)*c < 0x20) cost += 6;
+        else cost += 1;
+    }
+    return cost;
+}
+
+void publishBufferedLogs() {
+    if (!logRing || !mqttClient.connected()) return;
+
+    portENTER_CRITICAL(&logMux);
+    size_t pending = logCount;
+    size_t tail = (logHead + logCapacity - logCount) % logCapacity;
+    portEXIT_CRITICAL(&logMux);
+
+    if (pending == 0) return;
+
+    // A ring more than half full skips the interval so bursts drain quickly
+    if (pending < logCapacity / 2 && millis() - lastLogPublish < HIVE_LOG_PUBLISH_INTERVAL) return;
+    lastLogPublish = millis();
+
+    HiveMessage msg;
+    JsonArray entries = msg.doc["entries"].to<JsonArray>();
+
+    size_t bytes = 40;  // {"entries":[],"dropped":4294967295}
+    size_t batched = 0;
+    while (batched < pending) {
+        const LogEntry& entry = logRing[(tail + batched) % logCapacity];
+        size_t cost = entryCost(entry.msg);
+        if (batched > 0 && bytes + cost > HIVE_LOG_BATCH_BYTES) break;
+
+        JsonObject item = entries.add<JsonObject>();
+        item["ts"] = entry.ts;
+        item["msg"] = entry.msg;
+        bytes += cost;
+        batched++;
+    }
+    msg.doc["dropped"] = logDropped;
+
+    // Entries stay queued if the publish fails; retried next interval
+    if (!msg.publish(hive.topics().logs.c_str(), 0, false)) return;
+
+    portENTER_CRITICAL(&logMux);
+    logCount -= batched;
+    portEXIT_CRITICAL(&logMux);
+}
+
+HiveLogStats hiveLogStats() {
+    HiveLogStats stats;
+    portENTER_CRITICAL(&logMux);
+    stats.dropped = logDropped;
+    stats.queued = logCount;
+    portEXIT_CRITICAL(&logMux);
+    stats.capacity = logCapacity;
+    return stats;
+}
+
+void hiveLogTruncate(size_t queued) {
+    if (!logRing) return;
+
+    portENTER_CRITICAL(&logMux);
+    if (logCount > queued) {
+        logHead = (logHead + logCapacity - (logCount - queued)) % logCapacity;
+        logCount = queued;
+    }
+    portEXIT_CRITICAL(&logMux);
+}
+
+void mqttLog(const char* format, ...) {
+    char buffer[HIVE_LOG_MSG_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    // Always print to Serial
+    Serial.print(buffer);
+
+    if (!logRing) return;  // hiveLogInit() not called yet (Serial only)
+
+    // Remove newline for cleaner MQTT messages
+    size_t len = strlen(buffer);
+    if (len > 0 && buffer[len - 1] == '\n') {
+        buffer[--len] = '\0';
+    }
+
+    uint32_t ts = millis() / 1000;
+
+    portENTER_CRITICAL(&logMux);
+    if (logCount == logCapacity) {
+        logDropped++;
+    } else {
+        LogEntry& entry = logRing[logHead];
+        entry.ts = ts;
+        memcpy(entry.msg, buffer, len + 1);
+        logHead = (logHead + 1) % logCapacity;
+        logCount++;
+    }
+    portEXIT_CRITICAL(&logMux);
+}
@@ -0,0 +1,89 @@
+/**
+ * Hive Core - MQTT Logging
+ *
+ * mqttLog() prints to Serial and queues the line (with its timestamp) in
+ * a ring for the logs topic. hive.loop() drains the ring in batches once
+ * MQTT is connected:
+ *
+ *   {"entries":[{"ts":12,"msg":"[MQTT] Connected!"},...],"dropped":0}
+ *
+ * A full ring drops new lines instead of overwriting queued ones, and the
+ * count is reported as "dropped" here and log_dropped in health. On boards
+ * with PSRAM (BOARD_HAS_PSRAM) the ring lives there and is much larger.
+ *
+ * Log levels follow CORE_DEBUG_LEVEL unless HIVE_LOG_LEVEL is set; debug
+ * output below that level compiles to nothing:
+ *
+ *   hiveDebug("[Button] Left pressed\n");   // Serial only, DEBUG builds
+ *   mqttLogDebug("[LIFT] pos=%.1f\n", cm);  // Serial + MQTT, DEBUG builds
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define HIVE_LOG_NONE 0
+#define HIVE_LOG_ERROR 1
+#define HIVE_LOG_WARN 2
+#define HIVE_LOG_INFO 3
+#define HIVE_LOG_DEBUG 4
+#define HIVE_LOG_VERBOSE 5
+
+#ifndef HIVE_LOG_LEVEL
+#ifdef CORE_DEBUG_LEVEL
+#define HIVE_LOG_LEVEL CORE_DEBUG_LEVEL
+#else
+#define HIVE_LOG_LEVEL HIVE_LOG_INFO
+#endif
+#endif
+
+#ifndef HIVE_LOG_BUFFER_SIZE
+#ifdef BOARD_HAS_PSRAM
+#define HIVE_LOG_BUFFER_SIZE 512   // Ring entries in PSRAM (~66 KB)
+#else
+#define HIVE_LOG_BUFFER_SIZE 32    // Ring entries in internal RAM (~4 KB)
+#endif
+#endif
+
+#ifndef HIVE_LOG_INTERNAL_MAX
+#define HIVE_LOG_INTERNAL_MAX 32   // Ring cap if PSRAM allocation fails
+#endif
+
+#ifndef HIVE_LOG_MSG_SIZE
+#define HIVE_LOG_MSG_SIZE 128
+#endif
+
+#ifndef HIVE_LOG_PUBLISH_INTERVAL
+#define HIVE_LOG_PUBLISH_INTERVAL 500  // Publish a batch every 500ms
+#endif
+
+#ifndef HIVE_LOG_BATCH_BYTES
+#define HIVE_LOG_BATCH_BYTES (HIVE_TX_BUFFER_SIZE - 64)  // Serialized batch budget
+#endif
+
+struct HiveLogStats {
+    uint32_t dropped;  // Lines lost because the ring was full
+    size_t queued;     // Lines waiting to be published
+    size_t capacity;   // Ring size actually allocated
+};
+
+void hiveLogInit();
+void mqttLog(const char* format, ...) __attribute__((format(printf, 1, 2)));
+void publishBufferedLogs();
+HiveLogStats hiveLogStats();
+// Unqueue the newest lines so only `queued` remain (benchmarks, before MQTT connects)
+void hiveLogTruncate(size_t queued);
+
+#if HIVE_LOG_LEVEL >= HIVE_LOG_DEBUG
+#define hiveDebug(...) Serial.printf(__VA_ARGS__)
+#define mqttLogDebug(...) mqttLog(__VA_ARGS__)
+#else
+#define hiveDebug(...) do {} while (0)
+#define mqttLogDebug(...) do {} while (0)
+#endif
+
+#if HIVE_LOG_LEVEL >= HIVE_LOG_VERBOSE
+#define hiveVerbose(...) Serial.printf(__VA_ARGS__)
+#else
+#define hiveVerbose(...) do {} while (0)
+#endif
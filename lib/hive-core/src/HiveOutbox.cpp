@@ -0,0 +1,111 @@
+/**
+ * Hive Core - Offline Store-and-Forward
+ */
+
+#include "HiveOutbox.h"
+#include "HiveCore.h"
+
+#include <esp_heap_caps.h>
+
+HIVE_PER_BEE HiveOutbox hiveOutbox;
+
+// Events come from loop(), the MQTT task and web handlers; only the ring
+// indices are shared, queued entries are never overwritten while replaying
+static HIVE_PER_BEE portMUX_TYPE outboxMux = portMUX_INITIALIZER_UNLOCKED;
+
+void HiveOutbox::begin() {
+    if (_ring) return;
+
+    size_t capacity = HIVE_OUTBOX_SIZE;
+#ifdef BOARD_HAS_PSRAM
+    _ring = (Entry*)heap_caps_malloc(capacity * sizeof(Entry), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#endif
+    if (!_ring) {
+        if (capacity > HIVE_OUTBOX_INTERNAL_MAX) capacity = HIVE_OUTBOX_INTERNAL_MAX;
+        _ring = (Entry*)malloc(capacity * sizeof(Entry));
+    }
+    _capacity = _ring ? capacity : 0;
+}
+
+bool HiveOutbox::record(const char* topic, const char* payload, size_t len) {
+    if (!_ring) return false;
+
+    // Last topic level names the stream, e.g. ".../devices/<id>/switch" -> "switch"
+    const char* leaf = strrchr(topic, '/');
+    leaf = leaf ? leaf + 1 : topic;
+    uint32_t ts = millis();
+
+    portENTER_CRITICAL(&outboxMux);
+    bool stored = len <= HIVE_OUTBOX_PAYLOAD_SIZE && _count < _capacity;
+    if (stored) {
+        Entry& entry = _ring[_head];
+        entry.ts = ts;
+        entry.len = len;
+        strncpy(entry.leaf, leaf, sizeof(entry.leaf) - 1);
+        entry.leaf[sizeof(entry.leaf) - 1] = '\0';
+        memcpy(entry.payload, payload, len);
+        _head = (_head + 1) % _capacity;
+        _count++;
+        _recorded++;
+    } else {
+        _dropped++;
+    }
+    portEXIT_CRITICAL(&outboxMux);
+    return stored;
+}
+
+bool HiveOutbox::replay() {
+    if (!_ring || !hive.mqttConnected()) return false;
+
+    portENTER_CRITICAL(&outboxMux);
+    size_t pending = _count;
+    size_t tail = (_head + _capacity - _count) % _capacity;
+    portEXIT_CRITICAL(&outboxMux);
+
+    if (pending == 0 || millis() - _lastReplay < HIVE_OUTBOX_REPLAY_INTERVAL) return false;
+    _lastReplay = millis();
+
+    uint32_t now = millis();
+    HiveMessage msg;
+    JsonArray entries = msg.doc["entries"].to<JsonArray>();
+
+    size_t bytes = 40;  // {"entries":[],"dropped":4294967295}
+    size_t batched = 0;
+    while (batched < pending) {
+        const Entry& entry = _ring[(tail + batched) % _capacity];
+        size_t cost = 44 + strlen(entry.leaf) + entry.len;  // {"topic":"","age_ms":4294967295,"data":},
+        if (batched > 0 && bytes + cost > HIVE_OUTBOX_BATCH_BYTES) break;
+
+        JsonObject item = entries.add<JsonObject>();
+        item["topic"] = entry.leaf;
+        item["age_ms"] = now - entry.ts;
+        item["data"] = serialized(entry.payload, entry.len);  // Already JSON
+        bytes += cost;
+        batched++;
+    }
+    msg.doc["dropped"] = _dropped;
+
+    // QoS1, and entries stay queued if the client refuses the batch
+    if (!msg.publish(hive.topics().replay.c_str(), 1, false)) return false;
+
+    portENTER_CRITICAL(&outboxMux);
+    _count -= batched;
+    _replayed += batched;
+    pending = _count;
+    portEXIT_CRITICAL(&outboxMux);
+
+    if (pending == 0) mqttLog("[Outbox] Replay done (%u events since boot)\n", (unsigned)_replayed);
+    return true;
+}
+
+HiveOutboxStats HiveOutbox::stats() const {
+    HiveOutboxStats stats;
+    portENTER_CRITICAL(&outboxMux);
+    stats.queued = _count;
+    stats.recorded = _recorded;
+    stats.replayed = _replayed;
+    stats.dropped = _dropped;
+    portEXIT_CRITICAL(&outboxMux);
+    stats.capacity = _capacity;
+    return stats;
+}
@@ -0,0 +1,101 @@
+/**
+ * Hive Core - Offline Store-and-Forward
+ *
+ * Events that matter after the fact (switch changes, lift stops, health
+ * samples during an outage) are published with publishEvent() instead of
+ * publish(). Connected, that is a plain publish; offline - or when the
+ * client refuses the packet - the serialized payload is queued in a ring
+ * with its timestamp instead of being lost:
+ *
+ *   HiveMessage msg;
+ *   msg.doc["switch"] = switchNames[i];
+ *   msg.publishEvent(switchTopic.c_str());
+ *
+ * After a reconnect hive.loop() replays the ring as batches on the replay
+ * topic, after the scheduled state/discovery/health and at most one batch
+ * per HIVE_OUTBOX_REPLAY_INTERVAL so a reconnect doesn't flood the broker:
+ *
+ *   {"entries":[{"topic":"switch","age_ms":8200,"data":{...}},...],"dropped":0}
+ *
+ * "topic" is the last level of the original topic and age_ms how long ago
+ * the event happened. Like the log ring, a full ring drops new events and
+ * counts them (outbox_dropped in health); with BOARD_HAS_PSRAM it lives in
+ * PSRAM and holds much more.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "HivePlatform.h"
+#include "HivePublish.h"
+
+#ifndef HIVE_OUTBOX_SIZE
+#ifdef BOARD_HAS_PSRAM
+#define HIVE_OUTBOX_SIZE 256             // Ring entries in PSRAM (~50 KB)
+#else
+#define HIVE_OUTBOX_SIZE 16              // Ring entries in internal RAM (~3 KB)
+#endif
+#endif
+
+#ifndef HIVE_OUTBOX_INTERNAL_MAX
+#define HIVE_OUTBOX_INTERNAL_MAX 16      // Ring cap if PSRAM allocation fails
+#endif
+
+#ifndef HIVE_OUTBOX_PAYLOAD_SIZE
+#define HIVE_OUTBOX_PAYLOAD_SIZE 176     // Largest queued event; bigger ones are dropped
+#endif
+
+#ifndef HIVE_OUTBOX_REPLAY_INTERVAL
+#define HIVE_OUTBOX_REPLAY_INTERVAL 250  // Min gap between replay batches
+#endif
+
+#ifndef HIVE_OUTBOX_BATCH_BYTES
+#define HIVE_OUTBOX_BATCH_BYTES (HIVE_TX_BUFFER_SIZE - 64)  // Serialized batch budget
+#endif
+
+#ifndef HIVE_OUTBOX_HEALTH_INTERVAL
+#define HIVE_OUTBOX_HEALTH_INTERVAL 10000  // Health sample queued per 10s of outage
+#endif
+
+#define HIVE_OUTBOX_LEAF_SIZE 16
+
+struct HiveOutboxStats {
+    size_t queued;       // Events waiting for replay
+    size_t capacity;     // Ring size actually allocated
+    uint32_t recorded;   // Events queued since boot
+    uint32_t replayed;   // Events published from the ring since boot
+    uint32_t dropped;    // Ring full or event too large
+};
+
+class HiveOutbox {
+public:
+    void begin();
+
+    // Queue a serialized JSON payload for replay; safe from any task
+    bool record(const char* topic, const char* payload, size_t len);
+
+    // One batch if connected and due; true if a batch went out
+    bool replay();
+
+    HiveOutboxStats stats() const;
+
+private:
+    struct Entry {
+        uint32_t ts;      // millis() when recorded
+        uint16_t len;
+        char leaf[HIVE_OUTBOX_LEAF_SIZE];
+        char payload[HIVE_OUTBOX_PAYLOAD_SIZE];
+    };
+
+    Entry* _ring = nullptr;
+    size_t _capacity = 0;
+    size_t _head = 0;    // Next slot to write
+    size_t _count = 0;   // Queued entries ending at _head
+    uint32_t _recorded = 0;
+    uint32_t _replayed = 0;
+    uint32_t _dropped = 0;
+    unsigned long _lastReplay = 0;
+};
+
+extern HIVE_PER_BEE HiveOutbox hiveOutbox;
@@ -0,0 +1,205 @@
+/**
+ * Hive Core - Loop & Subsystem Profiling
+ */
+
+#include "HivePerf.h"
+
+#if HIVE_PERF
+
+HIVE_PER_BEE HivePerf hivePerf;
+
+// Upper bound of each jitter bucket (us); the last bucket takes the rest
+static const uint32_t jitterEdges[HIVE_PERF_JITTER_BUCKETS - 1] = {100, 500, 1000, 5000, 10000, 50000};
+
+// ============== Scopes ==============
+
+HivePerfScope* HivePerf::scope(const char* name) {
+    HivePerfScope* entry = nullptr;
+    portENTER_CRITICAL(&_mux);
+    if (_scopeCount < HIVE_PERF_MAX_SCOPES) {
+        entry = &_scopes[_scopeCount++];
+        entry->name = name;
+    }
+    portEXIT_CRITICAL(&_mux);
+    if (!entry) Serial.printf("[Perf] No slot for scope %s\n", name);
+    return entry;
+}
+
+void HivePerf::record(HivePerfScope* scope, uint32_t us) {
+    portENTER_CRITICAL(&_mux);
+    scope->count++;
+    scope->totalUs += us;
+    if (us > scope->maxUs) scope->maxUs = us;
+    portEXIT_CRITICAL(&_mux);
+}
+
+// ============== Tasks ==============
+
+void HivePerf::watchTask(TaskHandle_t task) {
+    if (!task) task = xTaskGetCurrentTaskHandle();
+
+    portENTER_CRITICAL(&_mux);
+    bool known = false;
+    for (size_t i = 0; i < _taskCount; i++) {
+        if (_tasks[i].handle == task) known = true;
+    }
+    if (!known && _taskCount < HIVE_PERF_MAX_TASKS) {
+        Task& entry = _tasks[_taskCount++];
+        entry.handle = task;
+        entry.name = pcTaskGetName(task);
+        entry.stackFree = uxTaskGetStackHighWaterMark(task);
+    }
+    portEXIT_CRITICAL(&_mux);
+}
+
+// ============== Loop ==============
+
+void HivePerf::loopTick() {
+    uint32_t now = micros();
+
+    if (!_loopTask) {
+        _loopTask = xTaskGetCurrentTaskHandle();
+        watchTask(_loopTask);
+        _windowStart = now;
+    }
+
+    if (_lastTick) {
+        uint32_t period = now - _lastTick;
+        uint32_t jitter = period > _lastPeriod ? period - _lastPeriod : _lastPeriod - period;
+
+        size_t bucket = 0;
+        while (bucket < HIVE_PERF_JITTER_BUCKETS - 1 && jitter > jitterEdges[bucket]) bucket++;
+
+        if (_loop.count == 0 || period < _loop.minUs) _loop.minUs = period;
+        if (period > _loop.maxUs) _loop.maxUs = period;
+        _loop.totalUs += period;
+        _loop.count++;
+        _loop.jitter[bucket]++;
+        _lastPeriod = period;
+    }
+    _lastTick = now;
+
+    if (now - _windowStart >= HIVE_PERF_WINDOW * 1000UL) rollWindow(now);
+}
+
+void HivePerf::rollWindow(uint32_t now) {
+    // Outside the lock: walks each task's stack
+    uint32_t stackFree[HIVE_PERF_MAX_TASKS];
+    for (size_t i = 0; i < _taskCount; i++) {
+        stackFree[i] = uxTaskGetStackHighWaterMark(_tasks[i].handle);
+    }
+
+    portENTER_CRITICAL(&_mux);
+    _lastLoop = _loop;
+    _loop = {};
+    for (size_t i = 0; i < _scopeCount; i++) {
+        HivePerfScope& scope = _scopes[i];
+        scope.lastCount = scope.count;
+        scope.lastTotalUs = scope.totalUs;
+        scope.lastMaxUs = scope.maxUs;
+        scope.count = 0;
+        scope.totalUs = 0;
+        scope.maxUs = 0;
+    }
+    for (size_t i = 0; i < _taskCount; i++) {
+        _tasks[i].stackFree = stackFree[i];
+    }
+    _lastWindowUs = now - _windowStart;
+    _windowStart = now;
+    portEXIT_CRITICAL(&_mux);
+}
+
+// ============== Reports ==============
+
+void HivePerf::json(JsonObject out) {
+    // Snapshot under the lock, serialize outside it
+    HivePerfScope scopes[HIVE_PERF_MAX_SCOPES];
+    Task tasks[HIVE_PERF_MAX_TASKS];
+    portENTER_CRITICAL(&_mux);
+    LoopStats loop = _lastLoop;
+    uint32_t windowUs = _lastWindowUs;
+    size_t scopeCount = _scopeCount;
+    size_t taskCount = _taskCount;
+    memcpy(scopes, _scopes, sizeof(HivePerfScope) * scopeCount);
+    memcpy(tasks, _tasks, sizeof(Task) * taskCount);
+    portEXIT_CRITICAL(&_mux);
+
+    out["enabled"] = true;
+    out["window_ms"] = windowUs / 1000;
+    out["cpu_mhz"] = getCpuFrequencyMhz();
+
+    JsonObject loopOut = out["loop"].to<JsonObject>();
+    loopOut["count"] = loop.count;
+    loopOut["hz"] = windowUs > 0 ? (float)loop.count * 1000000.0f / windowUs : 0;
+    loopOut["min_us"] = loop.minUs;
+    loopOut["avg_us"] = loop.count > 0 ? (uint32_t)(loop.totalUs / loop.count) : 0;
+    loopOut["max_us"] = loop.maxUs;
+
+    JsonObject jitter = out["jitter"].to<JsonObject>();
+    JsonArray edges = jitter["le_us"].to<JsonArray>();
+    for (uint32_t edge : jitterEdges) edges.add(edge);
+    JsonArray counts = jitter["counts"].to<JsonArray>();
+    for (uint32_t count : loop.jitter) counts.add(count);
+
+    JsonObject heap = out["heap"].to<JsonObject>();
+    heap["free"] = ESP.getFreeHeap();
+    heap["min_free"] = ESP.getMinFreeHeap();
+    heap["largest_block"] = ESP.getMaxAllocHeap();
+
+    JsonArray scopesOut = out["scopes"].to<JsonArray>();
+    for (size_t i = 0; i < scopeCount; i++) {
+        const HivePerfScope& scope = scopes[i];
+        JsonObject item = scopesOut.add<JsonObject>();
+        item["name"] = scope.name;
+        item["count"] = scope.lastCount;
+        item["avg_us"] = scope.lastCount > 0 ? scope.lastTotalUs / scope.lastCount : 0;
+        item["max_us"] = scope.lastMaxUs;
+        item["total_us"] = scope.lastTotalUs;
+        item["pct"] = windowUs > 0 ? scope.lastTotalUs * 100.0f / windowUs : 0;  // Of wall time
+    }
+
+    JsonArray tasksOut = out["tasks"].to<JsonArray>();
+    for (size_t i = 0; i < taskCount; i++) {
+        JsonObject item = tasksOut.add<JsonObject>();
+        item["name"] = tasks[i].name;
+        item["stack_free_min"] = tasks[i].stackFree;
+    }
+}
+
+void HivePerf::healthJson(JsonObject out) {
+    HivePerfScope scopes[HIVE_PERF_MAX_SCOPES];
+    Task tasks[HIVE_PERF_MAX_TASKS];
+    portENTER_CRITICAL(&_mux);
+    LoopStats loop = _lastLoop;
+    size_t scopeCount = _scopeCount;
+    size_t taskCount = _taskCount;
+    memcpy(scopes, _scopes, sizeof(HivePerfScope) * scopeCount);
+    memcpy(tasks, _tasks, sizeof(Task) * taskCount);
+    portEXIT_CRITICAL(&_mux);
+
+    JsonArray loopUs = out["loop_us"].to<JsonArray>();
+    loopUs.add(loop.minUs);
+    loopUs.add(loop.count > 0 ? (uint32_t)(loop.totalUs / loop.count) : 0);
+    loopUs.add(loop.maxUs);
+
+    JsonArray jitter = out["jitter"].to<JsonArray>();
+    for (uint32_t count : loop.jitter) jitter.add(count);
+
+    out["heap_min"] = ESP.getMinFreeHeap();
+
+    JsonObject scopesOut = out["scopes"].to<JsonObject>();
+    for (size_t i = 0; i < scopeCount; i++) {
+        const HivePerfScope& scope = scopes[i];
+        JsonArray item = scopesOut[scope.name].to<JsonArray>();
+        item.add(scope.lastCount);
+        item.add(scope.lastCount > 0 ? scope.lastTotalUs / scope.lastCount : 0);
+        item.add(scope.lastMaxUs);
+    }
+
+    JsonObject stack = out["stack"].to<JsonObject>();
+    for (size_t i = 0; i < taskCount; i++) {
+        stack[tasks[i].name] = tasks[i].stackFree;
+    }
+}
+
+#endif
@@ -0,0 +1,151 @@
+/**
+ * Hive Core - Loop & Subsystem Profiling
+ *
+ * Compile-time opt-in (-DHIVE_PERF=1). Wrap a hot path in a scope:
+ *
+ *   void readSwitches() {
+ *       HIVE_PERF_SCOPE("readSwitches");
+ *       ...
+ *   }
+ *
+ * Each scope keeps call count, total and max time from micros() (two
+ * esp_timer reads and a short critical section per call). Not the cycle
+ * counter: under dynamic frequency scaling (kaycibee's esp_pm) the clock
+ * changes between calls, and getCpuFrequencyMhz() only reports the
+ * configured maximum.
+ * hive.loop() feeds the loop period min/avg/max and a histogram of the
+ * change in period from one loop to the next (jitter). Tasks call
+ * HIVE_PERF_TASK() once at start so their stack high-water mark is
+ * tracked; the task running hive.loop() is picked up automatically.
+ *
+ * Figures cover the last complete HIVE_PERF_WINDOW, so /api/perf and
+ * health never reset each other. They are served as GET /api/perf
+ * (hiveServePerf() in HiveWeb.h) and, with HIVE_PERF_HEALTH, as a compact
+ * "perf" object in health - raise HIVE_TX_BUFFER_SIZE on bees whose health
+ * is already near the limit (kaycibee).
+ *
+ * With HIVE_PERF 0 (default) the macros expand to nothing, nothing here
+ * is compiled and /api/perf answers {"enabled":false}.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "HivePlatform.h"
+
+#ifndef HIVE_PERF
+#define HIVE_PERF 0                     // 1 = compile in scopes, loop stats, /api/perf
+#endif
+
+#ifndef HIVE_PERF_HEALTH
+#define HIVE_PERF_HEALTH 1              // Add "perf" to health when HIVE_PERF is on
+#endif
+
+#ifndef HIVE_PERF_WINDOW
+#define HIVE_PERF_WINDOW 5000           // Reporting window (ms), matches health
+#endif
+
+#ifndef HIVE_PERF_MAX_SCOPES
+#define HIVE_PERF_MAX_SCOPES 12
+#endif
+
+#ifndef HIVE_PERF_MAX_TASKS
+#define HIVE_PERF_MAX_TASKS 8
+#endif
+
+#define HIVE_PERF_JITTER_BUCKETS 7      // <=100us, 500us, 1ms, 5ms, 10ms, 50ms, more
+
+#if HIVE_PERF
+
+struct HivePerfScope {
+    const char* name;
+    uint32_t count;         // Current window
+    uint32_t totalUs;
+    uint32_t maxUs;
+    uint32_t lastCount;     // Last complete window
+    uint32_t lastTotalUs;
+    uint32_t lastMaxUs;
+};
+
+class HivePerf {
+public:
+    // Registers a scope once (HIVE_PERF_SCOPE keeps the pointer in a per-bee static);
+    // nullptr when HIVE_PERF_MAX_SCOPES are taken
+    HivePerfScope* scope(const char* name);
+    void record(HivePerfScope* scope, uint32_t us);
+
+    // Stack high-water tracking for a task (default: the calling task)
+    void watchTask(TaskHandle_t task = nullptr);
+
+    // Called from hive.loop(): loop period, jitter, window roll-over
+    void loopTick();
+
+    // Full report for /api/perf
+    void json(JsonObject out);
+    // Compact form for health: loop_us [min,avg,max], scopes name:[n,avg_us,max_us]
+    void healthJson(JsonObject out);
+
+private:
+    struct LoopStats {
+        uint32_t count;
+        uint32_t minUs;
+        uint32_t maxUs;
+        uint64_t totalUs;
+        uint32_t jitter[HIVE_PERF_JITTER_BUCKETS];
+    };
+
+    struct Task {
+        TaskHandle_t handle;
+        const char* name;
+        uint32_t stackFree;   // Bytes never used, as of the last window
+    };
+
+    void rollWindow(uint32_t now);
+
+    HivePerfScope _scopes[HIVE_PERF_MAX_SCOPES] = {};
+    size_t _scopeCount = 0;
+    Task _tasks[HIVE_PERF_MAX_TASKS] = {};
+    size_t _taskCount = 0;
+
+    LoopStats _loop = {};
+    LoopStats _lastLoop = {};
+    TaskHandle_t _loopTask = nullptr;
+    uint32_t _lastTick = 0;
+    uint32_t _lastPeriod = 0;
+    uint32_t _windowStart = 0;
+    uint32_t _lastWindowUs = 0;
+
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+extern HIVE_PER_BEE HivePerf hivePerf;
+
+class HivePerfTimer {
+public:
+    explicit HivePerfTimer(HivePerfScope* scope) : _scope(scope), _start(micros()) {}
+    ~HivePerfTimer() {
+        if (_scope) hivePerf.record(_scope, micros() - _start);
+    }
+
+private:
+    HivePerfScope* _scope;
+    uint32_t _start;
+};
+
+#define HIVE_PERF_CAT_(a, b) a##b
+#define HIVE_PERF_CAT(a, b) HIVE_PERF_CAT_(a, b)
+// The cached pointer is per bee like hivePerf itself, or every swarm thread
+// would record into the scope of whichever bee got there first
+#define HIVE_PERF_SCOPE(name)                                                                     \
+    static HIVE_PER_BEE HivePerfScope* HIVE_PERF_CAT(_perfScope, __LINE__) = hivePerf.scope(name); \
+    HivePerfTimer HIVE_PERF_CAT(_perfTimer, __LINE__)(HIVE_PERF_CAT(_perfScope, __LINE__))
+#define HIVE_PERF_TASK() hivePerf.watchTask()
+
+#else
+
+#define HIVE_PERF_SCOPE(name)
+#define HIVE_PERF_TASK()
+
+#endif
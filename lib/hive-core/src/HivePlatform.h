@@ -0,0 +1,21 @@
+/**
+ * Hive Core - Platform Switches
+ *
+ * The core also builds for the host (-DHIVE_NATIVE, env:native-swarm) where
+ * one process runs hundreds of simulated bees, one thread each, on the
+ * shims in sim/shim. Every per-bee global and file-level static is declared
+ * HIVE_PER_BEE so each thread gets its own:
+ *
+ *   HIVE_PER_BEE HiveCore hive;
+ *   extern HIVE_PER_BEE HiveCore hive;     // and the same on the extern
+ *
+ * On the ESP32 it expands to nothing.
+ */
+
+#pragma once
+
+#ifdef HIVE_NATIVE
+#define HIVE_PER_BEE thread_local
+#else
+#define HIVE_PER_BEE
+#endif
@@ -0,0 +1,153 @@
+/**
+ * Hive Core - Zero-Allocation Publish Path
+ */
+
+#include "HivePublish.h"
+#include "HiveCore.h"
+
+// ============== Shared Buffers ==============
+
+alignas(8) static HIVE_PER_BEE uint8_t txPool[HIVE_JSON_ARENA_SIZE];
+static HIVE_PER_BEE HiveArena txArena(txPool, sizeof(txPool));
+static HIVE_PER_BEE char txBuffer[HIVE_TX_BUFFER_SIZE];
+static HIVE_PER_BEE SemaphoreHandle_t txMutex = nullptr;
+
+static HIVE_PER_BEE uint32_t txOverflows = 0;
+static HIVE_PER_BEE size_t txLargestPayload = 0;
+
+// Each block is prefixed with its size so reallocate() can copy old contents
+struct ArenaHeader {
+    size_t size;
+    size_t pad;  // Keep payload 8-byte aligned
+};
+
+static inline size_t alignUp(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+// ============== Arena ==============
+
+bool HiveArena::owns(const void* ptr) const {
+    return ptr >= _pool && ptr < _pool + _size;
+}
+
+void* HiveArena::allocate(size_t size) {
+    size_t needed = sizeof(ArenaHeader) + alignUp(size);
+    if (_used + needed > _size) {
+        _heapFallbacks++;
+        return malloc(size);
+    }
+
+    ArenaHeader* header = reinterpret_cast<ArenaHeader*>(_pool + _used);
+    header->size = size;
+    _last = _pool + _used;
+    _used += needed;
+    if (_used > _highWater) _highWater = _used;
+
+    return header + 1;
+}
+
+void HiveArena::deallocate(void* ptr) {
+    if (!ptr) return;
+    if (!owns(ptr)) {
+        free(ptr);
+        return;
+    }
+    // Arena blocks are released all at once by reset(), but give back the
+    // tail so ArduinoJson's grow/shrink cycles don't leak the pool.
+    uint8_t* block = reinterpret_cast<uint8_t*>(ptr) - sizeof(ArenaHeader);
+    if (block == _last) {
+        _used = block - _pool;
+        _last = nullptr;
+    }
+}
+
+void* HiveArena::reallocate(void* ptr, size_t newSize) {
+    if (!ptr) return allocate(newSize);
+    if (!owns(ptr)) return realloc(ptr, newSize);
+
+    uint8_t* block = reinterpret_cast<uint8_t*>(ptr) - sizeof(ArenaHeader);
+    ArenaHeader* header = reinterpret_cast<ArenaHeader*>(block);
+
+    // Last block: grow/shrink in place
+    if (block == _last) {
+        size_t start = block - _pool;
+        size_t needed = sizeof(ArenaHeader) + alignUp(newSize);
+        if (start + needed <= _size) {
+            header->size = newSize;
+            _used = start + needed;
+            if (_used > _highWater) _highWater = _used;
+            return ptr;
+        }
+    } else if (newSize <= header->size) {
+        header->size = newSize;
+        return ptr;
+    }
+
+    size_t oldSize = header->size;
+    void* moved = allocate(newSize);
+    if (!moved) return nullptr;
+    memcpy(moved, ptr, oldSize < newSize ? oldSize : newSize);
+    return moved;
+}
+
+// ============== TX Lock ==============
+
+void hivePublishInit() {
+    if (!txMutex) {
+        txMutex = xSemaphoreCreateMutex();
+    }
+}
+
+HiveTxLock::HiveTxLock() {
+    if (txMutex) xSemaphoreTake(txMutex, portMAX_DELAY);
+    txArena.reset();
+}
+
+HiveTxLock::~HiveTxLock() {
+    if (txMutex) xSemaphoreGive(txMutex);
+}
+
+// ============== Message ==============
+
+HiveMessage::HiveMessage() : doc(&txArena) {
+}
+
+bool HiveMessage::publish(const char* topic, uint8_t qos, bool retain) {
+    return send(topic, qos, retain, serializeJson(doc, txBuffer, sizeof(txBuffer)));
+}
+
+bool HiveMessage::publishMsgPack(const char* topic, uint8_t qos, bool retain) {
+    return send(topic, qos, retain, serializeMsgPack(doc, txBuffer, sizeof(txBuffer)));
+}
+
+bool HiveMessage::publishEvent(const char* topic, uint8_t qos) {
+    size_t len = serializeJson(doc, txBuffer, sizeof(txBuffer));
+    if (len == 0 || len >= sizeof(txBuffer) - 1) return send(topic, qos, false, len);  // Counts the overflow
+
+    if (hive.mqttConnected() && send(topic, qos, false, len)) return true;
+    hiveOutbox.record(topic, txBuffer, len);
+    return false;
+}
+
+bool HiveMessage::send(const char* topic, uint8_t qos, bool retain, size_t len) {
+    // Serializers truncate at the buffer end - treat a full buffer as overflow
+    if (len == 0 || len >= sizeof(txBuffer) - 1) {
+        txOverflows++;
+        Serial.printf("[MQTT] Payload for %s exceeds %d bytes, dropped\n", topic, HIVE_TX_BUFFER_SIZE);
+        return false;
+    }
+    if (len > txLargestPayload) txLargestPayload = len;
+    _length = len;
+
+    return mqttClient.publish(topic, qos, retain, (const uint8_t*)txBuffer, len) != 0;
+}
+
+HivePublishStats hivePublishStats() {
+    HivePublishStats stats;
+    stats.overflows = txOverflows;
+    stats.largestPayload = txLargestPayload;
+    stats.arenaHighWater = txArena.highWater();
+    stats.heapFallbacks = txArena.heapFallbacks();
+    return stats;
+}
@@ -0,0 +1,98 @@
+/**
+ * Hive Core - Zero-Allocation Publish Path
+ *
+ * Every outgoing JSON message is built in a static arena and serialized
+ * into a static TX buffer, so publishing health/state/discovery/logs does
+ * not touch the heap (espMqttClient still copies the payload into its
+ * outbox, but that is one block per packet instead of doc + String growth).
+ *
+ *   HiveMessage msg;
+ *   msg.doc["switch"] = switchNames[i];
+ *   msg.publish(topic, 0, false);
+ *
+ * Only one HiveMessage may be alive at a time - construction takes the TX
+ * lock (shared between loop() and the MQTT task) and resets the arena.
+ * Don't nest them (e.g. publishing from inside an onState/onHealth hook).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#ifndef HIVE_JSON_ARENA_SIZE
+#define HIVE_JSON_ARENA_SIZE 6144   // ArduinoJson pools + copied strings
+#endif
+
+#ifndef HIVE_TX_BUFFER_SIZE
+#define HIVE_TX_BUFFER_SIZE 2048    // Largest serialized payload (bedliftbee health with
+                                    // a broker list; kaycibee sets 3584 in platformio.ini)
+#endif
+
+// Bump allocator over a static block; anything that doesn't fit falls back
+// to the heap and is counted so the sizes above can be tuned from health.
+// The pool must be 8-byte aligned.
+class HiveArena : public ArduinoJson::Allocator {
+public:
+    HiveArena(uint8_t* pool, size_t size) : _pool(pool), _size(size) {}
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t newSize) override;
+
+    void reset() { _used = 0; _last = nullptr; }
+    size_t used() const { return _used; }
+    size_t highWater() const { return _highWater; }
+    uint32_t heapFallbacks() const { return _heapFallbacks; }
+
+private:
+    bool owns(const void* ptr) const;
+
+    uint8_t* _pool;
+    size_t _size;
+    size_t _used = 0;
+    size_t _highWater = 0;
+    uint8_t* _last = nullptr;  // Most recent block (can grow in place)
+    uint32_t _heapFallbacks = 0;
+};
+
+// Scoped TX lock + arena reset; must be constructed before the document
+class HiveTxLock {
+public:
+    HiveTxLock();
+    ~HiveTxLock();
+    HiveTxLock(const HiveTxLock&) = delete;
+    HiveTxLock& operator=(const HiveTxLock&) = delete;
+};
+
+class HiveMessage {
+public:
+    HiveMessage();
+
+    // Serialize into the shared TX buffer and publish; false if too large or offline
+    bool publish(const char* topic, uint8_t qos, bool retain);
+    bool publishMsgPack(const char* topic, uint8_t qos, bool retain);
+
+    // Not retained; queued for replay when it can't go out now (HiveOutbox.h)
+    bool publishEvent(const char* topic, uint8_t qos = 0);
+    size_t length() const { return _length; }  // Serialized size of last publish()
+
+private:
+    bool send(const char* topic, uint8_t qos, bool retain, size_t len);
+
+    size_t _length = 0;
+    HiveTxLock _lock;  // Declared before doc: locks + resets arena before doc exists
+
+public:
+    JsonDocument doc;
+};
+
+struct HivePublishStats {
+    uint32_t overflows;       // Payload didn't fit HIVE_TX_BUFFER_SIZE (dropped)
+    size_t largestPayload;    // Biggest serialized payload so far
+    size_t arenaHighWater;    // Peak arena use
+    uint32_t heapFallbacks;   // Arena exhausted, block came from heap
+};
+
+void hivePublishInit();
+HivePublishStats hivePublishStats();
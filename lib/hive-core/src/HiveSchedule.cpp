@@ -0,0 +1,77 @@
+/**
+ * Hive Core - Publish Scheduler
+ */
+
+#include "HiveSchedule.h"
+
+// Marks come from the MQTT task, web handlers and callbacks as well as loop()
+static HIVE_PER_BEE portMUX_TYPE scheduleMux = portMUX_INITIALIZER_UNLOCKED;
+
+void HiveScheduler::configure(HivePublishTopic topic, uint32_t minIntervalMs, uint32_t periodMs,
+                              bool skipUnchanged) {
+    Slot& slot = _slots[topic];
+    slot.minIntervalMs = minIntervalMs;
+    slot.periodMs = periodMs;
+    slot.skipUnchanged = skipUnchanged;
+}
+
+void HiveScheduler::request(HivePublishTopic topic, bool force) {
+    if (topic >= HIVE_PUB_TOPICS) return;
+    Slot& slot = _slots[topic];
+
+    portENTER_CRITICAL(&scheduleMux);
+    if (slot.dirty) _coalesced++;
+    slot.dirty = true;
+    if (force) slot.forced = true;
+    portEXIT_CRITICAL(&scheduleMux);
+}
+
+HivePublishTopic HiveScheduler::due(unsigned long now, bool flush) const {
+    for (uint8_t i = 0; i < HIVE_PUB_TOPICS; i++) {
+        const Slot& slot = _slots[i];
+        bool periodic = slot.periodMs > 0 && now - slot.lastSent >= slot.periodMs;
+        if (!slot.dirty && !periodic) continue;
+
+        // Leading edge goes now, the rest waits for the interval to end
+        bool throttled = slot.sentOnce && now - slot.lastSent < slot.minIntervalMs;
+        if (throttled && !slot.forced && !flush) continue;
+
+        return (HivePublishTopic)i;
+    }
+    return HIVE_PUB_NONE;
+}
+
+bool HiveScheduler::take(HivePublishTopic topic, unsigned long now) {
+    Slot& slot = _slots[topic];
+
+    // Cleared before the payload is built: a mark landing meanwhile sends again
+    portENTER_CRITICAL(&scheduleMux);
+    bool forced = slot.forced;
+    slot.dirty = false;
+    slot.forced = false;
+    portEXIT_CRITICAL(&scheduleMux);
+
+    slot.sentOnce = true;
+    slot.lastSent = now;
+    return forced;
+}
+
+bool HiveScheduler::changed(HivePublishTopic topic, uint32_t hash, bool forced) {
+    Slot& slot = _slots[topic];
+    if (slot.skipUnchanged && !forced && hash == slot.hash) {
+        _skipped++;
+        return false;
+    }
+    return true;
+}
+
+void HiveScheduler::sent(HivePublishTopic topic, uint32_t hash) {
+    _slots[topic].hash = hash;
+}
+
+HiveScheduleStats HiveScheduler::stats() const {
+    HiveScheduleStats stats;
+    stats.coalesced = _coalesced;
+    stats.skipped = _skipped;
+    return stats;
+}
@@ -0,0 +1,104 @@
+/**
+ * Hive Core - Publish Scheduler
+ *
+ * hive.publishState() and friends only mark their topic dirty, from any
+ * task; hive.loop() sends what is due, one message per pass, highest
+ * priority first (state, discovery, health; logs only on a pass nothing
+ * else needed). Marks that land before the send merge into one publish,
+ * so startLift() -> stopLift() -> publish twice costs one message.
+ *
+ * Each topic has a minimum interval: a mark after a quiet period goes out
+ * on the next pass (no added latency for a real change), further marks
+ * within the interval collapse into one trailing publish when it ends.
+ * Periodic republishes of state are skipped while the bee's fields hash
+ * the same as the last one sent - state is retained, so the broker
+ * already holds it. A reconnect forces everything out regardless.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "HivePlatform.h"
+
+#ifndef HIVE_STATE_MIN_INTERVAL
+#define HIVE_STATE_MIN_INTERVAL 200      // Bursts of state changes -> one publish per 200ms
+#endif
+
+#ifndef HIVE_DISCOVERY_MIN_INTERVAL
+#define HIVE_DISCOVERY_MIN_INTERVAL 1000
+#endif
+
+#ifndef HIVE_HEALTH_MIN_INTERVAL
+#define HIVE_HEALTH_MIN_INTERVAL 1000
+#endif
+
+// In priority order
+enum HivePublishTopic : uint8_t {
+    HIVE_PUB_STATE = 0,
+    HIVE_PUB_DISCOVERY,
+    HIVE_PUB_HEALTH,
+    HIVE_PUB_TOPICS,
+    HIVE_PUB_NONE = HIVE_PUB_TOPICS
+};
+
+// FNV-1a over a serialized document: serializeJson(doc, writer)
+struct HiveHashWriter {
+    uint32_t hash = 2166136261u;
+
+    size_t write(uint8_t c) {
+        hash = (hash ^ c) * 16777619u;
+        return 1;
+    }
+    size_t write(const uint8_t* bytes, size_t len) {
+        for (size_t i = 0; i < len; i++) write(bytes[i]);
+        return len;
+    }
+};
+
+struct HiveScheduleStats {
+    uint32_t coalesced;   // Marks merged into one already pending
+    uint32_t skipped;     // Periodic/requested publishes dropped as unchanged
+};
+
+class HiveScheduler {
+public:
+    void configure(HivePublishTopic topic, uint32_t minIntervalMs, uint32_t periodMs, bool skipUnchanged);
+
+    // Safe from any task; force bypasses the interval and the unchanged check
+    void request(HivePublishTopic topic, bool force = false);
+
+    // Highest-priority topic due now, or HIVE_PUB_NONE; flush ignores the
+    // minimum intervals (e.g. before deep sleep)
+    HivePublishTopic due(unsigned long now, bool flush = false) const;
+
+    // Claims a due topic: clears the mark and restarts its interval.
+    // Returns whether it was forced.
+    bool take(HivePublishTopic topic, unsigned long now);
+
+    // After building the payload: false (and counted) if the topic skips
+    // unchanged payloads and this one hashes like the last one sent
+    bool changed(HivePublishTopic topic, uint32_t hash, bool forced);
+
+    // The payload was handed to the client; later ones compare against it.
+    // Not called for a refused publish, so the next pass doesn't skip it.
+    void sent(HivePublishTopic topic, uint32_t hash);
+
+    HiveScheduleStats stats() const;
+
+private:
+    struct Slot {
+        uint32_t minIntervalMs = 0;
+        uint32_t periodMs = 0;          // 0 = only when requested
+        bool skipUnchanged = false;
+        volatile bool dirty = false;
+        volatile bool forced = false;
+        bool sentOnce = false;
+        unsigned long lastSent = 0;
+        uint32_t hash = 0;
+    };
+
+    Slot _slots[HIVE_PUB_TOPICS];
+    volatile uint32_t _coalesced = 0;
+    uint32_t _skipped = 0;
+};
@@ -0,0 +1,116 @@
+/**
+ * Hive Core - Delta Health Telemetry
+ */
+
+#include "HiveTelemetry.h"
+
+// ============== Hashing ==============
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+static uint32_t fnv1a(const void* data, size_t len, uint32_t hash = FNV_OFFSET) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint32_t fnv1a(const char* str) {
+    return fnv1a(str, strlen(str));
+}
+
+// Hashes whatever serializeJson() prints (nested objects/arrays only)
+class HashPrint : public Print {
+public:
+    size_t write(uint8_t c) override {
+        hash = (hash ^ c) * FNV_PRIME;
+        return 1;
+    }
+    uint32_t hash = FNV_OFFSET;
+};
+
+// Scalars are hashed from their raw value so unchanged fields cost no formatting
+static uint32_t hashValue(JsonVariant value) {
+    if (value.is<const char*>()) {
+        return fnv1a(value.as<const char*>());
+    }
+    if (value.is<bool>()) {
+        return value.as<bool>() ? 1 : 2;
+    }
+    if (value.is<long>()) {
+        long v = value.as<long>();
+        return fnv1a(&v, sizeof(v));
+    }
+    if (value.is<double>()) {
+        double v = value.as<double>();
+        return fnv1a(&v, sizeof(v), FNV_OFFSET ^ 0x5f);
+    }
+    HashPrint printer;
+    serializeJson(value, printer);
+    return printer.hash;
+}
+
+// ============== Encoder ==============
+
+const char* telemetryModeName(HiveTelemetryMode mode) {
+    switch (mode) {
+        case HIVE_TELEMETRY_DELTA:
+            return "delta";
+        case HIVE_TELEMETRY_MSGPACK:
+            return "msgpack";
+        default:
+            return "full";
+    }
+}
+
+bool HiveTelemetry::encode(JsonDocument& doc) {
+    bool keyframe = _keyframeDue || _sinceKeyframe >= HIVE_TELEMETRY_KEYFRAME_EVERY;
+
+    const char* unchanged[HIVE_TELEMETRY_MAX_FIELDS];
+    size_t unchangedCount = 0;
+
+    for (JsonPair kv : doc.as<JsonObject>()) {
+        const char* key = kv.key().c_str();
+        uint32_t keyHash = fnv1a(key);
+        uint32_t valueHash = hashValue(kv.value());
+
+        Field* field = nullptr;
+        for (uint8_t i = 0; i < _fieldCount; i++) {
+            if (_fields[i].key == keyHash) {
+                field = &_fields[i];
+                break;
+            }
+        }
+
+        bool changed = true;
+        if (field) {
+            changed = field->value != valueHash;
+            field->value = valueHash;
+        } else if (_fieldCount < HIVE_TELEMETRY_MAX_FIELDS) {
+            _fields[_fieldCount++] = {keyHash, valueHash};
+        }
+        // Table full: field is untracked and always sent
+
+        // timestamp always rides along so deltas can be placed in time
+        if (!keyframe && !changed && strcmp(key, "timestamp") != 0) {
+            unchanged[unchangedCount++] = key;
+        }
+    }
+
+    for (size_t i = 0; i < unchangedCount; i++) {
+        doc.remove(unchanged[i]);
+    }
+
+    doc["seq"] = ++_seq;
+    doc["kf"] = keyframe;
+
+    if (keyframe) {
+        _keyframeDue = false;
+        _sinceKeyframe = 0;
+    } else {
+        _sinceKeyframe++;
+    }
+    return keyframe;
+}
@@ -0,0 +1,64 @@
+/**
+ * Hive Core - Delta Health Telemetry
+ *
+ * Opt-in health mode that only sends the fields that changed since the
+ * last publish, plus a full keyframe every HIVE_TELEMETRY_KEYFRAME_EVERY
+ * messages and after every (re)connect:
+ *
+ *   {"uptime":205,"free_heap":181220,"timestamp":205113,"seq":41,"kf":false}
+ *
+ * Receivers keep the last record per device and merge deltas into it.
+ * A gap in seq means a delta was lost - wait for the next keyframe.
+ *
+ * Modes (HIVE_TELEMETRY_MODE build flag or hive.setTelemetryMode()):
+ *   HIVE_TELEMETRY_FULL     every field as JSON on .../health (default)
+ *   HIVE_TELEMETRY_DELTA    deltas as JSON on .../health
+ *   HIVE_TELEMETRY_MSGPACK  deltas as MessagePack on .../health/msgpack
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+enum HiveTelemetryMode : uint8_t {
+    HIVE_TELEMETRY_FULL = 0,
+    HIVE_TELEMETRY_DELTA = 1,
+    HIVE_TELEMETRY_MSGPACK = 2
+};
+
+#ifndef HIVE_TELEMETRY_MODE
+#define HIVE_TELEMETRY_MODE HIVE_TELEMETRY_FULL
+#endif
+
+#ifndef HIVE_TELEMETRY_KEYFRAME_EVERY
+#define HIVE_TELEMETRY_KEYFRAME_EVERY 12   // Full record every minute at 5s health
+#endif
+
+#ifndef HIVE_TELEMETRY_MAX_FIELDS
+#define HIVE_TELEMETRY_MAX_FIELDS 96       // Tracked top-level health fields (kaycibee ~85)
+#endif
+
+const char* telemetryModeName(HiveTelemetryMode mode);
+
+class HiveTelemetry {
+public:
+    // Strip fields unchanged since the last call and stamp seq/kf.
+    // Returns true if this message is a keyframe (nothing stripped).
+    bool encode(JsonDocument& doc);
+
+    void requestKeyframe() { _keyframeDue = true; }
+    uint32_t seq() const { return _seq; }
+
+private:
+    struct Field {
+        uint32_t key;    // FNV-1a of the field name
+        uint32_t value;  // FNV-1a of the last value sent
+    };
+
+    Field _fields[HIVE_TELEMETRY_MAX_FIELDS];
+    uint8_t _fieldCount = 0;
+    uint32_t _seq = 0;
+    uint16_t _sinceKeyframe = 0;
+    bool _keyframeDue = true;
+};
@@ -0,0 +1,122 @@
+/**
+ * Hive Core - Static Web UI
+ */
+
+// ESPAsyncWebServer only builds for the ESP32; the native swarm has no web UI
+#ifndef HIVE_NATIVE
+
+#include "HiveWeb.h"
+
+HiveLive hiveLive;
+
+// ============== Static Assets ==============
+
+void hiveServeAsset(AsyncWebServer& server, const char* uri, const HiveWebAsset& asset) {
+    const HiveWebAsset* page = &asset;
+    server.on(uri, HTTP_GET, [page](AsyncWebServerRequest* request) {
+        // Browser already has this build of the page
+        auto* cached = request->getHeader("If-None-Match");
+        if (cached && cached->value() == page->etag) {
+            request->send(304);
+            return;
+        }
+
+        AsyncWebServerResponse* response = request->beginResponse(200, page->contentType, page->data, page->length);
+        response->addHeader("Content-Encoding", "gzip");
+        response->addHeader("Cache-Control", "no-cache");  // Revalidate, usually a 304
+        response->addHeader("ETag", page->etag);
+        request->send(response);
+    });
+}
+
+// ============== Status JSON ==============
+
+JsonObject hiveStatusJson(JsonDocument& doc, const HiveConfig& config) {
+    doc["device_id"] = hive.deviceId();
+    doc["device_name"] = config.deviceName;
+    doc["mqtt_connected"] = hive.mqttConnected();
+    doc["mqtt_broker"] = hive.brokers().active().host;
+    doc["wifi_rssi"] = hive.rssi();
+    doc["uptime"] = hive.uptime();
+    doc["free_heap"] = ESP.getFreeHeap();
+    doc["firmware"] = hive.info().firmware;
+    doc["ip"] = hive.ip();
+
+    // Form values for /config, keyed by input name
+    JsonObject settings = doc["config"].to<JsonObject>();
+    settings["device_name"] = config.deviceName;
+    settings["mqtt_server"] = config.mqttServer;
+    settings["mqtt_port"] = config.mqttPort;
+    settings["mqtt_user"] = config.mqttUser;
+    return settings;
+}
+
+void hiveSendJson(AsyncWebServerRequest* request, const JsonDocument& doc) {
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->addHeader("Cache-Control", "no-store");
+    serializeJson(doc, *response);
+    request->send(response);
+}
+
+void hiveServePerf(AsyncWebServer& server) {
+    server.on("/api/perf", HTTP_GET, [](AsyncWebServerRequest* request) {
+        JsonDocument doc;
+#if HIVE_PERF
+        hivePerf.json(doc.to<JsonObject>());
+#else
+        doc["enabled"] = false;
+#endif
+        hiveSendJson(request, doc);
+    });
+}
+
+// ============== Live Status ==============
+
+void HiveLive::begin(AsyncWebServer& server, HiveJsonHook status) {
+    _status = status;
+
+    _events.onConnect([this](AsyncEventSourceClient* client) {
+        // Full snapshot first; loop() only sends what changes after this
+        JsonDocument doc;
+        _status(doc);
+        String json;
+        serializeJson(doc, json);
+        client->send(json.c_str(), "status", _delta.seq(), HIVE_LIVE_RETRY_MS);
+
+        // The encoder only knows what earlier clients were sent (nothing, if
+        // it sat idle with no clients) - resync everyone from this snapshot
+        _delta.requestKeyframe();
+    });
+    server.addHandler(&_events);
+}
+
+void HiveLive::loop() {
+    if (!_status) return;
+
+    // Nobody watching: don't build anything (new clients get a snapshot)
+    if (_events.count() == 0) {
+        _dirty = false;
+        return;
+    }
+
+    unsigned long now = millis();
+    unsigned long wait = _dirty ? HIVE_LIVE_MIN_INTERVAL : HIVE_LIVE_POLL_INTERVAL;
+    if (now - _lastSend < wait) return;
+    _dirty = false;
+    _lastSend = now;
+
+    JsonDocument doc;
+    _status(doc);
+    _delta.encode(doc);
+    if (doc.size() <= 2) return;  // Only seq/kf - nothing changed
+
+    if (measureJson(doc) >= sizeof(_buffer)) {
+        _delta.requestKeyframe();  // Dropped; resend everything next time
+        return;
+    }
+    serializeJson(doc, _buffer, sizeof(_buffer));
+    _events.send(_buffer, "delta", _delta.seq());
+    _sent++;
+}
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ * Hive Core - Static Web UI
+ *
+ * Bee web pages are plain files in web/<bee>/. tools/embed_web.py runs
+ * before every build (extra_scripts = pre:tools/embed_web.py), gzips each
+ * file and writes include/web/<bee>.h with one HiveWebAsset per file,
+ * named after it (index.html -> WEB_INDEX_HTML):
+ *
+ *   #include <HiveWeb.h>
+ *   #include "web/switchbee.h"
+ *
+ *   hiveServeAsset(webServer, "/", WEB_INDEX_HTML);
+ *   webServer.on("/api/status", HTTP_GET, [](AsyncWebServerRequest* request) {
+ *       JsonDocument doc;
+ *       hiveStatusJson(doc, config);
+ *       doc["led_state"] = state.ledOn;
+ *       hiveSendJson(request, doc);
+ *   });
+ *
+ * Assets stream straight from flash with Content-Encoding: gzip and an
+ * ETag of their content, so a page load allocates nothing per byte and a
+ * reload on the same firmware is a 304. Pages fetch their values from
+ * /api/status; the "config" object there feeds the settings form (the
+ * MQTT password is never sent, a blank password field keeps it).
+ *
+ * Live status (Server-Sent Events on /api/events) replaces polling:
+ *
+ *   hiveLive.begin(webServer, buildStatus);  // same builder as /api/status
+ *   hiveLive.notify();                       // after any state change
+ *   hiveLive.loop();                         // next to hive.loop()
+ *
+ * A client gets the full document as a "status" event when it connects,
+ * then "delta" events with only the fields that changed (HiveTelemetry
+ * encoding, so seq/kf ride along and a keyframe resyncs every few
+ * messages). notify() bursts coalesce to one event per
+ * HIVE_LIVE_MIN_INTERVAL; slow fields like uptime are picked up every
+ * HIVE_LIVE_POLL_INTERVAL. With no client connected nothing is built.
+ *
+ * hiveServePerf(webServer) adds GET /api/perf with the HivePerf report
+ * ({"enabled":false} unless built with HIVE_PERF=1).
+ *
+ * Not included by HiveCore.h - only bees running ESPAsyncWebServer need it.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+
+#include "HiveCore.h"
+
+#ifndef HIVE_LIVE_MIN_INTERVAL
+#define HIVE_LIVE_MIN_INTERVAL 50      // Coalesce notify() bursts (ms)
+#endif
+
+#ifndef HIVE_LIVE_POLL_INTERVAL
+#define HIVE_LIVE_POLL_INTERVAL 1000   // Unnotified changes (uptime, RSSI)
+#endif
+
+#ifndef HIVE_LIVE_BUFFER_SIZE
+#define HIVE_LIVE_BUFFER_SIZE 1024     // Largest serialized delta
+#endif
+
+#define HIVE_LIVE_RETRY_MS 2000        // EventSource reconnect hint
+
+struct HiveWebAsset {
+    const char* contentType;
+    const uint8_t* data;  // Gzipped, in flash
+    size_t length;
+    const char* etag;     // Quoted content hash
+};
+
+void hiveServeAsset(AsyncWebServer& server, const char* uri, const HiveWebAsset& asset);
+
+// Fields every bee reports; returns the "config" object for bee settings
+JsonObject hiveStatusJson(JsonDocument& doc, const HiveConfig& config);
+
+// Streams the document without building a String first
+void hiveSendJson(AsyncWebServerRequest* request, const JsonDocument& doc);
+
+// GET /api/perf (see HivePerf.h)
+void hiveServePerf(AsyncWebServer& server);
+
+class HiveLive {
+public:
+    void begin(AsyncWebServer& server, HiveJsonHook status);
+    void loop();
+
+    // Safe from any task (web handlers, ISR-deferred loop code)
+    void notify() { _dirty = true; }
+
+    size_t clients() const { return _events.count(); }
+    uint32_t sent() const { return _sent; }
+
+private:
+    AsyncEventSource _events{"/api/events"};
+    HiveJsonHook _status = nullptr;
+    HiveTelemetry _delta;
+    volatile bool _dirty = false;
+    unsigned long _lastSend = 0;
+    uint32_t _sent = 0;
+    char _buffer[HIVE_LIVE_BUFFER_SIZE];
+};
+
+extern HiveLive hiveLive;
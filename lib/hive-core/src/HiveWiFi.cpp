@@ -0,0 +1,134 @@
+/**
+ * Hive Core - Fast WiFi Connect
+ */
+
+#include "HiveWiFi.h"
+#include "HiveCore.h"
+
+#include <Preferences.h>
+#include <esp_wifi.h>
+
+#define HIVE_WIFI_MAGIC 0x48574931  // "HWI1"
+
+HIVE_PER_BEE HiveWiFi hiveWiFi;
+
+// Survives resets and deep sleep; NVS copy covers power loss
+RTC_NOINIT_ATTR static HIVE_PER_BEE HiveWiFiLink rtcLink;
+
+static uint32_t linkChecksum(const HiveWiFiLink& link) {
+    const uint8_t* bytes = (const uint8_t*)&link;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(HiveWiFiLink, checksum); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool linkValid(const HiveWiFiLink& link) {
+    return link.magic == HIVE_WIFI_MAGIC && link.channel > 0 && link.checksum == linkChecksum(link);
+}
+
+bool HiveWiFi::load() {
+    if (linkValid(rtcLink)) {
+        _link = rtcLink;
+        return true;
+    }
+
+    Preferences prefs;
+    if (!prefs.begin("hivewifi", true)) return false;
+    size_t len = prefs.getBytes("link", &_link, sizeof(_link));
+    prefs.end();
+
+    if (len != sizeof(_link) || !linkValid(_link)) return false;
+    rtcLink = _link;
+    return true;
+}
+
+void HiveWiFi::store() {
+    _link.magic = HIVE_WIFI_MAGIC;
+    _link.checksum = linkChecksum(_link);
+    rtcLink = _link;
+
+    Preferences prefs;
+    prefs.begin("hivewifi", false);
+    prefs.putBytes("link", &_link, sizeof(_link));
+    prefs.end();
+}
+
+bool HiveWiFi::fastConnect(uint32_t timeoutMs) {
+    _fast = false;
+    if (!load()) return false;
+
+    // Credentials from the driver's own NVS copy (saved by WiFiManager)
+    WiFi.mode(WIFI_STA);
+    wifi_config_t conf;
+    if (esp_wifi_get_config(WIFI_IF_STA, &conf) != ESP_OK || conf.sta.ssid[0] == 0) return false;
+
+    char ssid[33];
+    char pass[65];
+    memcpy(ssid, conf.sta.ssid, 32);
+    ssid[32] = '\0';
+    memcpy(pass, conf.sta.password, 64);
+    pass[64] = '\0';
+
+#if HIVE_FAST_CONNECT_STATIC_IP
+    WiFi.config(IPAddress(_link.ip), IPAddress(_link.gateway), IPAddress(_link.subnet), IPAddress(_link.dns));
+#endif
+
+    unsigned long started = millis();
+    Serial.printf("[WiFi] Fast connect to %s (ch %d)...\n", ssid, _link.channel);
+    WiFi.begin(ssid, pass, _link.channel, _link.bssid, true);
+
+    while (WiFi.status() != WL_CONNECTED && millis() - started < timeoutMs) {
+        delay(10);
+    }
+    _connectMs = millis() - started;
+
+    if (WiFi.status() == WL_CONNECTED) {
+        _fast = true;
+        Serial.printf("[WiFi] Fast connect in %lu ms\n", (unsigned long)_connectMs);
+        return true;
+    }
+
+    // AP moved channel, changed BSSID or is gone - scan from scratch
+    Serial.printf("[WiFi] Fast connect failed after %lu ms, scanning\n", (unsigned long)_connectMs);
+    WiFi.disconnect();
+#if HIVE_FAST_CONNECT_STATIC_IP
+    WiFi.config(IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0));  // Back to DHCP
+#endif
+    forget();
+    return false;
+}
+
+void HiveWiFi::remember() {
+    hive.markBoot(HIVE_BOOT_WIFI);
+    if (!WiFi.isConnected()) return;
+
+    HiveWiFiLink link = {};
+    memcpy(link.bssid, WiFi.BSSID(), sizeof(link.bssid));
+    link.channel = WiFi.channel();
+    link.ip = (uint32_t)WiFi.localIP();
+    link.gateway = (uint32_t)WiFi.gatewayIP();
+    link.subnet = (uint32_t)WiFi.subnetMask();
+    link.dns = (uint32_t)WiFi.dnsIP();
+
+    // Same AP and lease as last boot: no flash write
+    HiveWiFiLink current = _link;
+    current.magic = 0;
+    current.checksum = 0;
+    if (linkValid(_link) && memcmp(&current, &link, sizeof(link)) == 0) return;
+
+    _link = link;
+    store();
+    Serial.printf("[WiFi] Remembered AP (ch %d) for fast connect\n", link.channel);
+}
+
+void HiveWiFi::forget() {
+    memset(&_link, 0, sizeof(_link));
+    rtcLink = _link;
+
+    Preferences prefs;
+    prefs.begin("hivewifi", false);
+    prefs.remove("link");
+    prefs.end();
+}
@@ -0,0 +1,67 @@
+/**
+ * Hive Core - Fast WiFi Connect
+ *
+ * WiFiManager scans and runs DHCP on every boot. After a good connection
+ * the AP's BSSID/channel and the DHCP lease are remembered (RTC memory,
+ * mirrored to NVS only when they change), so the next boot joins that AP
+ * directly and WiFiManager is only the fallback:
+ *
+ *   if (!hiveWiFi.fastConnect()) {
+ *       wifiManager.autoConnect(apName);  // scan + config portal, as before
+ *   }
+ *   hiveWiFi.remember();                  // marks HIVE_BOOT_WIFI too
+ *
+ * fastConnect() uses the credentials the WiFi driver already keeps in NVS
+ * (written by WiFiManager), so nothing secret is stored twice. A failed
+ * attempt forgets the cache so the fallback starts clean.
+ *
+ * With HIVE_FAST_CONNECT_STATIC_IP=1 the remembered lease is applied
+ * without DHCP - only safe when the router reserves that IP for the bee.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#include "HivePlatform.h"
+
+#ifndef HIVE_FAST_CONNECT_TIMEOUT
+#define HIVE_FAST_CONNECT_TIMEOUT 4000   // Give up and scan after 4s
+#endif
+
+#ifndef HIVE_FAST_CONNECT_STATIC_IP
+#define HIVE_FAST_CONNECT_STATIC_IP 0    // Reuse the lease without DHCP
+#endif
+
+struct HiveWiFiLink {
+    uint32_t magic;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+    uint32_t checksum;
+};
+
+class HiveWiFi {
+public:
+    bool fastConnect(uint32_t timeoutMs = HIVE_FAST_CONNECT_TIMEOUT);
+    void remember();
+    void forget();
+
+    bool fastConnected() const { return _fast; }     // This boot skipped the scan
+    uint32_t connectMs() const { return _connectMs; }  // Duration of the fast attempt
+
+private:
+    bool load();
+    void store();
+
+    HiveWiFiLink _link = {};
+    bool _fast = false;
+    uint32_t _connectMs = 0;
+};
+
+extern HIVE_PER_BEE HiveWiFi hiveWiFi;
@@ -0,0 +1,273 @@
+/**
+ * Swarm Sim - Arduino Host Shim
+ *
+ * Just enough of the Arduino/ESP32 core for hive-core to build and run on
+ * the host (env:native-swarm). Every simulated bee is one thread, so
+ * anything a real bee has one of (Serial prefix, MAC, uptime) is
+ * thread_local here. FreeRTOS primitives map onto std::mutex/std::thread.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define PROGMEM
+#define F(x) x
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 1
+#define OUTPUT 2
+#define INPUT_PULLUP 5
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// macOS and glibc >= 2.38 have it
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t copy = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, copy);
+        dst[copy] = 0;
+    }
+    return len;
+}
+#endif
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+using std::max;
+using std::min;
+
+// ============== Time ==============
+
+inline const std::chrono::steady_clock::time_point simEpoch = std::chrono::steady_clock::now();
+
+// One clock for the whole process so bee timestamps and the controller agree
+inline unsigned long micros() {
+    return (unsigned long)(uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - simEpoch).count();
+}
+
+inline unsigned long millis() {
+    return (unsigned long)(uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - simEpoch).count();
+}
+
+inline void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+inline void yield() {
+    std::this_thread::yield();
+}
+
+// ============== Random ==============
+
+inline std::mt19937& simRng() {
+    thread_local std::mt19937 rng(std::random_device{}());
+    return rng;
+}
+
+inline long random(long howBig) {
+    return howBig > 0 ? (long)(simRng()() % (uint32_t)howBig) : 0;
+}
+
+inline long random(long howSmall, long howBig) {
+    return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+inline void randomSeed(unsigned long seed) {
+    simRng().seed(seed);
+}
+
+// ============== GPIO (no hardware) ==============
+
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+inline int digitalRead(int) { return HIGH; }
+inline uint16_t analogRead(int) { return 0; }
+inline uint32_t analogReadMilliVolts(int) { return 0; }
+
+// ============== String ==============
+
+class String {
+public:
+    String() {}
+    String(const char* text) { if (text) _s = text; }
+    String(const std::string& text) : _s(text) {}
+    String(char c) : _s(1, c) {}
+    String(int value) : _s(std::to_string(value)) {}
+    String(unsigned int value) : _s(std::to_string(value)) {}
+    String(long value) : _s(std::to_string(value)) {}
+    String(unsigned long value) : _s(std::to_string(value)) {}
+    String(float value, unsigned int decimals = 2) : String((double)value, decimals) {}
+    String(double value, unsigned int decimals = 2) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+        _s = buf;
+    }
+
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return (unsigned int)_s.size(); }
+    bool isEmpty() const { return _s.empty(); }
+    void reserve(unsigned int size) { _s.reserve(size); }
+
+    char operator[](unsigned int index) const { return index < _s.size() ? _s[index] : 0; }
+    char charAt(unsigned int index) const { return (*this)[index]; }
+
+    String& operator+=(const String& other) { _s += other._s; return *this; }
+    String& operator+=(const char* other) { if (other) _s += other; return *this; }
+    String& operator+=(char c) { _s += c; return *this; }
+    bool concat(const String& other) { _s += other._s; return true; }
+
+    friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+    friend String operator+(const String& a, const char* b) { return String(a._s + (b ? b : "")); }
+    friend String operator+(const char* a, const String& b) { return String((a ? a : "") + b._s); }
+
+    bool operator==(const String& other) const { return _s == other._s; }
+    bool operator==(const char* other) const { return other && _s == other; }
+    bool operator!=(const String& other) const { return _s != other._s; }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return _s < other._s; }
+    bool equals(const char* other) const { return *this == other; }
+
+    bool startsWith(const String& prefix) const { return _s.compare(0, prefix._s.size(), prefix._s) == 0; }
+    bool endsWith(const String& suffix) const {
+        return _s.size() >= suffix._s.size() &&
+               _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0;
+    }
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t at = _s.find(c, from);
+        return at == std::string::npos ? -1 : (int)at;
+    }
+    int indexOf(const char* text, unsigned int from = 0) const {
+        size_t at = _s.find(text, from);
+        return at == std::string::npos ? -1 : (int)at;
+    }
+    String substring(unsigned int from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        return from < to && from < _s.size() ? String(_s.substr(from, to - from)) : String();
+    }
+    long toInt() const { return atol(_s.c_str()); }
+    float toFloat() const { return (float)atof(_s.c_str()); }
+    void toLowerCase() { for (char& c : _s) c = (char)tolower((unsigned char)c); }
+    void toUpperCase() { for (char& c : _s) c = (char)toupper((unsigned char)c); }
+    void trim() {
+        size_t first = _s.find_first_not_of(" \t\r\n");
+        size_t last = _s.find_last_not_of(" \t\r\n");
+        _s = first == std::string::npos ? std::string() : _s.substr(first, last - first + 1);
+    }
+
+private:
+    std::string _s;
+};
+
+// ============== Serial ==============
+
+// Bees are quiet unless the swarm runs with --verbose; each line is
+// prefixed with the bee that printed it
+inline std::atomic<bool> simSerialEnabled{false};
+inline thread_local char simSerialPrefix[24] = "";
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) { return write(&c, 1); }
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        if (simSerialEnabled) fwrite(buffer, 1, size, stdout);
+        return size;
+    }
+
+    size_t print(const char* text) { return printf("%s", text); }
+    size_t print(const String& text) { return print(text.c_str()); }
+    size_t print(long value) { return printf("%ld", value); }
+    size_t println(const char* text = "") { return printf("%s\n", text); }
+    size_t println(const String& text) { return println(text.c_str()); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        if (!simSerialEnabled) return 0;
+        char line[512];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+        if (len <= 0) return 0;
+        std::lock_guard<std::mutex> lock(simSerialMutex());
+        fputs(simSerialPrefix, stdout);
+        fputs(line, stdout);
+        return (size_t)len;
+    }
+
+    void flush() { fflush(stdout); }
+
+private:
+    static std::mutex& simSerialMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    int available() { return 0; }
+    operator bool() const { return true; }
+};
+
+inline HardwareSerial Serial;
+
+// ============== ESP ==============
+
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 200000; }
+    uint32_t getMinFreeHeap() { return 180000; }
+    uint32_t getMaxAllocHeap() { return 110000; }
+    uint32_t getHeapSize() { return 320000; }
+    uint32_t getCycleCount() { return (uint32_t)micros() * 240; }
+    uint64_t getEfuseMac() { return efuseMac; }
+    void restart() {
+        fprintf(stderr, "%sESP.restart() - not supported in the swarm sim\n", simSerialPrefix);
+    }
+
+    // Set per bee thread before hive.begin(); the device ID is derived from it
+    static thread_local uint64_t efuseMac;
+};
+
+inline thread_local uint64_t EspClass::efuseMac = 0;
+inline EspClass ESP;
+
+inline uint32_t getCpuFrequencyMhz() { return 240; }
+inline bool setCpuFrequencyMhz(uint32_t) { return true; }
+
+#include "freertos_shim.h"
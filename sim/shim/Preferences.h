@@ -0,0 +1,105 @@
+/**
+ * Swarm Sim - Preferences Host Shim
+ *
+ * In-memory NVS, one store per bee thread; nothing survives the process.
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+#include <map>
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false) {
+        _ns = &store()[name];
+        _readOnly = readOnly;
+        return true;
+    }
+
+    void end() { _ns = nullptr; }
+
+    bool clear() {
+        if (!writable()) return false;
+        _ns->clear();
+        return true;
+    }
+
+    bool remove(const char* key) { return writable() && _ns->erase(key) > 0; }
+    bool isKey(const char* key) { return find(key) != nullptr; }
+
+    size_t putBytes(const char* key, const void* value, size_t len) {
+        if (!writable()) return 0;
+        const uint8_t* bytes = (const uint8_t*)value;
+        (*_ns)[key].assign(bytes, bytes + len);
+        return len;
+    }
+
+    size_t getBytes(const char* key, void* buf, size_t maxLen) {
+        const std::vector<uint8_t>* value = find(key);
+        if (!value || value->size() > maxLen) return 0;
+        memcpy(buf, value->data(), value->size());
+        return value->size();
+    }
+
+    size_t getBytesLength(const char* key) {
+        const std::vector<uint8_t>* value = find(key);
+        return value ? value->size() : 0;
+    }
+
+    size_t putString(const char* key, const char* value) { return putBytes(key, value, strlen(value) + 1); }
+    size_t putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+
+    size_t getString(const char* key, char* buf, size_t maxLen) {
+        const std::vector<uint8_t>* value = find(key);
+        if (!value || value->size() > maxLen) return 0;
+        memcpy(buf, value->data(), value->size());
+        return value->size();
+    }
+
+    String getString(const char* key, const String& defaultValue = String()) {
+        const std::vector<uint8_t>* value = find(key);
+        return value ? String((const char*)value->data()) : defaultValue;
+    }
+
+    size_t putInt(const char* key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putULong(const char* key, unsigned long value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putBool(const char* key, bool value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putFloat(const char* key, float value) { return putBytes(key, &value, sizeof(value)); }
+
+    int32_t getInt(const char* key, int32_t defaultValue = 0) { return get(key, defaultValue); }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return get(key, defaultValue); }
+    unsigned long getULong(const char* key, unsigned long defaultValue = 0) { return get(key, defaultValue); }
+    bool getBool(const char* key, bool defaultValue = false) { return get(key, defaultValue); }
+    float getFloat(const char* key, float defaultValue = 0) { return get(key, defaultValue); }
+
+private:
+    typedef std::map<std::string, std::vector<uint8_t>> Namespace;
+
+    static std::map<std::string, Namespace>& store() {
+        thread_local std::map<std::string, Namespace> namespaces;
+        return namespaces;
+    }
+
+    bool writable() const { return _ns && !_readOnly; }
+
+    const std::vector<uint8_t>* find(const char* key) const {
+        if (!_ns) return nullptr;
+        auto it = _ns->find(key);
+        return it == _ns->end() ? nullptr : &it->second;
+    }
+
+    template <typename T>
+    T get(const char* key, T defaultValue) {
+        const std::vector<uint8_t>* value = find(key);
+        if (!value || value->size() != sizeof(T)) return defaultValue;
+        T result;
+        memcpy(&result, value->data(), sizeof(T));
+        return result;
+    }
+
+    Namespace* _ns = nullptr;
+    bool _readOnly = false;
+};
@@ -0,0 +1,130 @@
+/**
+ * Swarm Sim - WiFi Host Shim
+ *
+ * Every bee is "associated" from the start on the loopback address with
+ * a slightly noisy RSSI. WiFiClient is a real (blocking) TCP socket for
+ * code that wants one; hive-core itself only talks to the broker through
+ * the espMqttClient shim.
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+typedef int wl_status_t;
+#define WL_IDLE_STATUS 0
+#define WL_DISCONNECTED 6
+#define WL_CONNECTED 3
+
+#define WIFI_OFF 0
+#define WIFI_STA 1
+
+class IPAddress {
+public:
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+    IPAddress(uint32_t address) { memcpy(_bytes, &address, sizeof(_bytes)); }
+
+    operator uint32_t() const {
+        uint32_t address;
+        memcpy(&address, _bytes, sizeof(address));
+        return address;
+    }
+    uint8_t operator[](int index) const { return _bytes[index & 3]; }
+
+    String toString() const {
+        char text[16];
+        snprintf(text, sizeof(text), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+        return String(text);
+    }
+
+private:
+    uint8_t _bytes[4] = {0, 0, 0, 0};
+};
+
+class WiFiClass {
+public:
+    bool isConnected() { return true; }
+    wl_status_t status() { return WL_CONNECTED; }
+    int RSSI() { return -55 - (int)random(6); }
+    int32_t channel() { return 6; }
+    uint8_t* BSSID() { return _bssid; }
+    IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+    IPAddress gatewayIP() { return IPAddress(127, 0, 0, 1); }
+    IPAddress subnetMask() { return IPAddress(255, 0, 0, 0); }
+    IPAddress dnsIP(uint8_t = 0) { return IPAddress(127, 0, 0, 1); }
+    String SSID() { return String("swarm"); }
+
+    bool mode(int mode) { _mode = mode; return true; }
+    int getMode() { return _mode; }
+    wl_status_t begin(const char* = nullptr, const char* = nullptr, int32_t = 0, const uint8_t* = nullptr,
+                      bool = true) {
+        return WL_CONNECTED;
+    }
+    bool config(IPAddress, IPAddress, IPAddress, IPAddress = IPAddress(), IPAddress = IPAddress()) { return true; }
+    bool disconnect(bool = false, bool = false) { return true; }
+    bool setSleep(bool) { return true; }
+
+private:
+    uint8_t _bssid[6] = {0x02, 0x53, 0x57, 0x41, 0x52, 0x4d};
+    int _mode = WIFI_STA;
+};
+
+inline WiFiClass WiFi;
+
+// Blocking connect with a timeout, then closed again by stop()
+class WiFiClient {
+public:
+    ~WiFiClient() { stop(); }
+
+    int connect(const char* host, uint16_t port, int32_t timeoutMs = 3000) {
+        stop();
+        char service[8];
+        snprintf(service, sizeof(service), "%u", port);
+        addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(host, service, &hints, &result) != 0 || !result) return 0;
+
+        _fd = socket(result->ai_family, SOCK_STREAM, 0);
+        bool ok = false;
+        if (_fd >= 0) {
+            fcntl(_fd, F_SETFL, O_NONBLOCK);
+            if (::connect(_fd, result->ai_addr, result->ai_addrlen) == 0) {
+                ok = true;
+            } else if (errno == EINPROGRESS) {
+                pollfd pfd = {_fd, POLLOUT, 0};
+                int error = 0;
+                socklen_t len = sizeof(error);
+                ok = poll(&pfd, 1, timeoutMs) == 1 &&
+                     getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0;
+            }
+        }
+        freeaddrinfo(result);
+        if (!ok) stop();
+        return ok ? 1 : 0;
+    }
+
+    int connect(IPAddress ip, uint16_t port, int32_t timeoutMs = 3000) {
+        return connect(ip.toString().c_str(), port, timeoutMs);
+    }
+
+    void stop() {
+        if (_fd >= 0) close(_fd);
+        _fd = -1;
+    }
+
+    bool connected() const { return _fd >= 0; }
+
+private:
+    int _fd = -1;
+};
@@ -0,0 +1,385 @@
+/**
+ * Swarm Sim - espMqttClient Host Shim
+ */
+
+#include "espMqttClient.h"
+
+using espMqttClientTypes::DisconnectReason;
+
+// ============== Packet Encoding ==============
+
+static void appendLength(std::string& packet, size_t length) {
+    do {
+        uint8_t digit = length % 128;
+        length /= 128;
+        if (length > 0) digit |= 0x80;
+        packet += (char)digit;
+    } while (length > 0);
+}
+
+static void appendU16(std::string& packet, uint16_t value) {
+    packet += (char)(value >> 8);
+    packet += (char)(value & 0xff);
+}
+
+static void appendString(std::string& packet, const std::string& text) {
+    appendU16(packet, (uint16_t)text.size());
+    packet += text;
+}
+
+static std::string framePacket(uint8_t header, const std::string& body) {
+    std::string packet(1, (char)header);
+    appendLength(packet, body.size());
+    packet += body;
+    return packet;
+}
+
+static uint16_t readU16(const uint8_t* bytes) {
+    return (uint16_t)((bytes[0] << 8) | bytes[1]);
+}
+
+// ============== Setup ==============
+
+espMqttClient::~espMqttClient() {
+    if (_fd >= 0) close(_fd);
+}
+
+espMqttClient& espMqttClient::onConnect(espMqttClientTypes::OnConnectCallback callback) {
+    _onConnect = callback;
+    return *this;
+}
+
+espMqttClient& espMqttClient::onDisconnect(espMqttClientTypes::OnDisconnectCallback callback) {
+    _onDisconnect = callback;
+    return *this;
+}
+
+espMqttClient& espMqttClient::onMessage(espMqttClientTypes::OnMessageCallback callback) {
+    _onMessage = callback;
+    return *this;
+}
+
+espMqttClient& espMqttClient::onPublish(espMqttClientTypes::OnPublishCallback callback) {
+    _onPublish = callback;
+    return *this;
+}
+
+espMqttClient& espMqttClient::setServer(const char* host, uint16_t port) {
+    _host = host;
+    _port = port;
+    return *this;
+}
+
+espMqttClient& espMqttClient::setCredentials(const char* username, const char* password) {
+    _username = username ? username : "";
+    _password = password ? password : "";
+    return *this;
+}
+
+espMqttClient& espMqttClient::setKeepAlive(uint16_t seconds) {
+    _keepAlive = seconds;
+    return *this;
+}
+
+espMqttClient& espMqttClient::setWill(const char* topic, uint8_t qos, bool retain, const char* payload) {
+    _willTopic = topic ? topic : "";
+    _willPayload = payload ? payload : "";
+    _willQos = qos;
+    _willRetain = retain;
+    return *this;
+}
+
+espMqttClient& espMqttClient::setClientId(const char* clientId) {
+    _clientId = clientId ? clientId : "";
+    return *this;
+}
+
+espMqttClient& espMqttClient::setCleanSession(bool cleanSession) {
+    _cleanSession = cleanSession;
+    return *this;
+}
+
+// ============== Connection ==============
+
+bool espMqttClient::connect() {
+    if (_state != State::DISCONNECTED) return false;
+
+    char service[8];
+    snprintf(service, sizeof(service), "%u", _port);
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(_host.c_str(), service, &hints, &result) != 0 || !result) {
+        closeSocket(DisconnectReason::TCP_DISCONNECTED);
+        return false;
+    }
+
+    _fd = socket(result->ai_family, SOCK_STREAM, 0);
+    if (_fd >= 0) {
+        fcntl(_fd, F_SETFL, O_NONBLOCK);
+        if (::connect(_fd, result->ai_addr, result->ai_addrlen) != 0 && errno != EINPROGRESS) {
+            close(_fd);
+            _fd = -1;
+        }
+    }
+    freeaddrinfo(result);
+
+    if (_fd < 0) {
+        closeSocket(DisconnectReason::TCP_DISCONNECTED);
+        return false;
+    }
+
+    _state = State::TCP_CONNECTING;
+    _connectStarted = millis();
+    return true;
+}
+
+bool espMqttClient::disconnect(bool force) {
+    if (_state == State::DISCONNECTED) return false;
+
+    // A clean DISCONNECT tells the broker to discard the will
+    if (!force && _state == State::CONNECTED) {
+        queuePacket(std::string("\xe0\x00", 2));
+    }
+    closeSocket(DisconnectReason::USER_OK);
+    return true;
+}
+
+void espMqttClient::sendConnect() {
+    uint8_t flags = 0;
+    if (!_username.empty()) flags |= 0x80;
+    if (!_password.empty()) flags |= 0x40;
+    if (!_willTopic.empty()) {
+        flags |= 0x04 | (uint8_t)(_willQos << 3);
+        if (_willRetain) flags |= 0x20;
+    }
+    if (_cleanSession) flags |= 0x02;
+
+    std::string body;
+    appendString(body, "MQTT");
+    body += (char)4;  // MQTT 3.1.1
+    body += (char)flags;
+    appendU16(body, _keepAlive);
+    appendString(body, _clientId);
+    if (!_willTopic.empty()) {
+        appendString(body, _willTopic);
+        appendString(body, _willPayload);
+    }
+    if (!_username.empty()) appendString(body, _username);
+    if (!_password.empty()) appendString(body, _password);
+
+    _state = State::MQTT_CONNECTING;
+    _lastReceived = millis();
+    queuePacket(framePacket(0x10, body));
+}
+
+void espMqttClient::closeSocket(DisconnectReason reason) {
+    if (_fd >= 0) {
+        flush();  // Best effort for a final DISCONNECT
+        close(_fd);
+    }
+    _fd = -1;
+    _state = State::DISCONNECTED;
+    _out.clear();
+    _in.clear();
+    if (_cleanSession) _inflight.clear();  // Otherwise resent on the next CONNACK
+
+    if (_onDisconnect) _onDisconnect(reason);
+}
+
+// ============== Subscribe / Publish ==============
+
+uint16_t espMqttClient::nextPacketId() {
+    if (++_packetId == 0) _packetId = 1;
+    return _packetId;
+}
+
+uint16_t espMqttClient::subscribe(const char* topic, uint8_t qos) {
+    if (_state != State::CONNECTED) return 0;
+
+    uint16_t packetId = nextPacketId();
+    std::string body;
+    appendU16(body, packetId);
+    appendString(body, topic);
+    body += (char)(qos > 1 ? 1 : qos);
+    queuePacket(framePacket(0x82, body));
+    return packetId;
+}
+
+uint16_t espMqttClient::publish(const char* topic, uint8_t qos, bool retain, const char* payload) {
+    return publish(topic, qos, retain, (const uint8_t*)payload, payload ? strlen(payload) : 0);
+}
+
+uint16_t espMqttClient::publish(const char* topic, uint8_t qos, bool retain, const uint8_t* payload,
+                                size_t length) {
+    if (_state != State::CONNECTED) return 0;
+    if (qos > 1) qos = 1;
+
+    uint16_t packetId = qos > 0 ? nextPacketId() : 1;
+    std::string body;
+    appendString(body, topic);
+    if (qos > 0) appendU16(body, packetId);
+    body.append((const char*)payload, length);
+
+    std::string packet = framePacket((uint8_t)(0x30 | (qos << 1) | (retain ? 1 : 0)), body);
+    if (qos > 0) _inflight.push_back({packetId, packet});
+    queuePacket(packet);
+    return packetId;
+}
+
+// ============== Socket I/O ==============
+
+void espMqttClient::queuePacket(const std::string& packet) {
+    _out += packet;
+    flush();
+}
+
+// Errors are left for loop() to notice, so a publish never calls back into HiveCore
+void espMqttClient::flush() {
+    while (_fd >= 0 && !_out.empty() && _state != State::TCP_CONNECTING) {
+        ssize_t sent = send(_fd, _out.data(), _out.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent <= 0) return;
+        _out.erase(0, (size_t)sent);
+        _lastSent = millis();
+    }
+}
+
+void espMqttClient::loop() {
+    if (_state == State::DISCONNECTED) return;
+
+    if (_state == State::TCP_CONNECTING) {
+        pollfd pfd = {_fd, POLLOUT, 0};
+        if (poll(&pfd, 1, 0) <= 0) return;
+
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error != 0) {
+            closeSocket(DisconnectReason::TCP_DISCONNECTED);
+            return;
+        }
+        sendConnect();
+    }
+
+    flush();
+    readPackets();
+    if (_state != State::CONNECTED) return;
+
+    unsigned long now = millis();
+    if (_keepAlive > 0) {
+        if (now - _lastReceived > _keepAlive * 1500UL) {
+            closeSocket(DisconnectReason::TCP_DISCONNECTED);
+            return;
+        }
+        if (now - _lastSent >= _keepAlive * 750UL) {
+            queuePacket(std::string("\xc0\x00", 2));  // PINGREQ
+        }
+    }
+}
+
+void espMqttClient::readPackets() {
+    uint8_t chunk[2048];
+    while (_fd >= 0) {
+        ssize_t received = recv(_fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+        if (received > 0) {
+            _in.append((const char*)chunk, (size_t)received);
+            _lastReceived = millis();
+            continue;
+        }
+        if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            closeSocket(DisconnectReason::TCP_DISCONNECTED);
+            return;
+        }
+        break;
+    }
+
+    while (_state != State::DISCONNECTED && _in.size() >= 2) {
+        size_t length = 0;
+        size_t multiplier = 1;
+        size_t pos = 1;
+        bool complete = false;
+        while (pos < _in.size() && pos <= 4) {
+            uint8_t digit = (uint8_t)_in[pos++];
+            length += (digit & 0x7f) * multiplier;
+            multiplier *= 128;
+            if (!(digit & 0x80)) {
+                complete = true;
+                break;
+            }
+        }
+        if (!complete || _in.size() < pos + length) return;
+
+        // Handlers may publish or disconnect: work on a copy
+        std::string packet = _in.substr(0, pos + length);
+        _in.erase(0, pos + length);
+        handlePacket((uint8_t)packet[0], (const uint8_t*)packet.data() + pos, length);
+    }
+}
+
+void espMqttClient::handlePacket(uint8_t header, const uint8_t* body, size_t len) {
+    switch (header >> 4) {
+        case 2: {  // CONNACK
+            if (len < 2) break;
+            bool sessionPresent = body[0] & 0x01;
+            if (body[1] != 0) {
+                closeSocket(body[1] <= 5 ? (DisconnectReason)body[1] : DisconnectReason::MQTT_SERVER_UNAVAILABLE);
+                return;
+            }
+            _state = State::CONNECTED;
+            // Unacked QoS1 from the last session go again with DUP set
+            for (const Inflight& entry : _inflight) {
+                std::string packet = entry.packet;
+                packet[0] = (char)(packet[0] | 0x08);
+                queuePacket(packet);
+            }
+            if (_onConnect) _onConnect(sessionPresent);
+            break;
+        }
+        case 3: {  // PUBLISH
+            uint8_t qos = (header >> 1) & 0x03;
+            if (len < 2) break;
+            size_t topicLen = readU16(body);
+            size_t offset = 2 + topicLen;
+            uint16_t packetId = 0;
+            if (qos > 0) {
+                if (len < offset + 2) break;
+                packetId = readU16(body + offset);
+                offset += 2;
+            }
+            if (len < offset) break;
+
+            std::string topic((const char*)body + 2, topicLen);
+            espMqttClientTypes::MessageProperties properties = {qos, (header & 0x08) != 0, (header & 0x01) != 0,
+                                                               packetId};
+            if (_onMessage) _onMessage(properties, topic.c_str(), body + offset, len - offset, 0, len - offset);
+
+            if (qos == 1 || qos == 2) {
+                std::string ack;
+                appendU16(ack, packetId);
+                queuePacket(framePacket(qos == 1 ? 0x40 : 0x50, ack));  // PUBACK / PUBREC
+            }
+            break;
+        }
+        case 4: {  // PUBACK
+            if (len < 2) break;
+            uint16_t packetId = readU16(body);
+            for (size_t i = 0; i < _inflight.size(); i++) {
+                if (_inflight[i].packetId == packetId) {
+                    _inflight.erase(_inflight.begin() + i);
+                    if (_onPublish) _onPublish(packetId);
+                    break;
+                }
+            }
+            break;
+        }
+        case 6: {  // PUBREL -> PUBCOMP
+            if (len < 2) break;
+            std::string ack;
+            appendU16(ack, readU16(body));
+            queuePacket(framePacket(0x70, ack));
+            break;
+        }
+        default:  // SUBACK, PINGRESP: nothing to do
+            break;
+    }
+}
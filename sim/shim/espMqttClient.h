@@ -0,0 +1,119 @@
+/**
+ * Swarm Sim - espMqttClient Host Shim
+ *
+ * The slice of the espMqttClient API hive-core uses, as a small MQTT 3.1.1
+ * client over a non-blocking POSIX socket, so every simulated bee holds a
+ * real broker connection (session, LWT, QoS1 acks, keep-alive).
+ *
+ * There is no network task: loop() does the socket I/O and runs the
+ * callbacks on the calling thread. HiveCore::loop() calls it under
+ * HIVE_NATIVE. QoS 2 is not implemented (hive-core never uses it).
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include "WiFi.h"
+
+namespace espMqttClientTypes {
+
+enum class DisconnectReason : uint8_t {
+    USER_OK = 0,
+    MQTT_UNACCEPTABLE_PROTOCOL_VERSION = 1,
+    MQTT_IDENTIFIER_REJECTED = 2,
+    MQTT_SERVER_UNAVAILABLE = 3,
+    MQTT_MALFORMED_CREDENTIALS = 4,
+    MQTT_NOT_AUTHORIZED = 5,
+    TLS_BAD_FINGERPRINT = 6,
+    TCP_DISCONNECTED = 7,
+};
+
+struct MessageProperties {
+    uint8_t qos;
+    bool dup;
+    bool retain;
+    uint16_t packetId;
+};
+
+typedef void (*OnConnectCallback)(bool sessionPresent);
+typedef void (*OnDisconnectCallback)(DisconnectReason reason);
+typedef void (*OnMessageCallback)(const MessageProperties& properties, const char* topic,
+                                  const uint8_t* payload, size_t len, size_t index, size_t total);
+typedef void (*OnPublishCallback)(uint16_t packetId);
+
+}  // namespace espMqttClientTypes
+
+class espMqttClient {
+public:
+    ~espMqttClient();
+
+    espMqttClient& onConnect(espMqttClientTypes::OnConnectCallback callback);
+    espMqttClient& onDisconnect(espMqttClientTypes::OnDisconnectCallback callback);
+    espMqttClient& onMessage(espMqttClientTypes::OnMessageCallback callback);
+    espMqttClient& onPublish(espMqttClientTypes::OnPublishCallback callback);
+
+    espMqttClient& setServer(const char* host, uint16_t port);
+    espMqttClient& setCredentials(const char* username, const char* password);
+    espMqttClient& setKeepAlive(uint16_t seconds);
+    espMqttClient& setWill(const char* topic, uint8_t qos, bool retain, const char* payload);
+    espMqttClient& setClientId(const char* clientId);
+    espMqttClient& setCleanSession(bool cleanSession);
+
+    bool connect();
+    bool disconnect(bool force = false);
+    bool connected() const { return _state == State::CONNECTED; }
+    bool disconnected() const { return _state == State::DISCONNECTED; }
+
+    uint16_t subscribe(const char* topic, uint8_t qos);
+    uint16_t publish(const char* topic, uint8_t qos, bool retain, const char* payload);
+    uint16_t publish(const char* topic, uint8_t qos, bool retain, const uint8_t* payload, size_t length);
+
+    // QoS1 publishes not yet acknowledged by the broker
+    size_t queueSize() const { return _inflight.size(); }
+    const char* getClientId() const { return _clientId.c_str(); }
+
+    void loop();
+
+private:
+    enum class State { DISCONNECTED, TCP_CONNECTING, MQTT_CONNECTING, CONNECTED };
+
+    struct Inflight {
+        uint16_t packetId;
+        std::string packet;
+    };
+
+    uint16_t nextPacketId();
+    void queuePacket(const std::string& packet);
+    void flush();
+    void readPackets();
+    void handlePacket(uint8_t header, const uint8_t* body, size_t len);
+    void sendConnect();
+    void closeSocket(espMqttClientTypes::DisconnectReason reason);
+
+    espMqttClientTypes::OnConnectCallback _onConnect = nullptr;
+    espMqttClientTypes::OnDisconnectCallback _onDisconnect = nullptr;
+    espMqttClientTypes::OnMessageCallback _onMessage = nullptr;
+    espMqttClientTypes::OnPublishCallback _onPublish = nullptr;
+
+    std::string _host;
+    uint16_t _port = 1883;
+    std::string _username;
+    std::string _password;
+    std::string _clientId;
+    std::string _willTopic;
+    std::string _willPayload;
+    uint8_t _willQos = 0;
+    bool _willRetain = false;
+    bool _cleanSession = true;
+    uint16_t _keepAlive = 15;
+
+    int _fd = -1;
+    State _state = State::DISCONNECTED;
+    std::string _out;           // Bytes not yet accepted by the socket
+    std::string _in;            // Bytes of a partially received packet
+    std::vector<Inflight> _inflight;
+    uint16_t _packetId = 0;
+    unsigned long _lastSent = 0;
+    unsigned long _lastReceived = 0;
+    unsigned long _connectStarted = 0;
+};
@@ -0,0 +1,7 @@
+/**
+ * Swarm Sim - heap_caps_*() live in freertos_shim.h (no PSRAM on the host)
+ */
+
+#pragma once
+
+#include "Arduino.h"
@@ -0,0 +1,36 @@
+/**
+ * Swarm Sim - ESP-NOW Host Shim
+ *
+ * There is no radio: esp_now_init() fails, so hiveLink stays down and
+ * hiveLink.send() takes the MQTT path like a bee out of range.
+ */
+
+#pragma once
+
+#include "esp_wifi.h"
+
+#define ESP_NOW_MAX_DATA_LEN 250
+#define ESP_NOW_ETH_ALEN 6
+
+typedef struct {
+    uint8_t* src_addr;
+    uint8_t* des_addr;
+    void* rx_ctrl;
+} esp_now_recv_info_t;
+
+typedef void (*esp_now_recv_cb_t)(const esp_now_recv_info_t* info, const uint8_t* data, int len);
+
+typedef struct {
+    uint8_t peer_addr[ESP_NOW_ETH_ALEN];
+    uint8_t lmk[16];
+    uint8_t channel;
+    wifi_interface_t ifidx;
+    bool encrypt;
+    void* priv;
+} esp_now_peer_info_t;
+
+inline esp_err_t esp_now_init() { return ESP_FAIL; }
+inline esp_err_t esp_now_deinit() { return ESP_OK; }
+inline esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t) { return ESP_FAIL; }
+inline esp_err_t esp_now_add_peer(const esp_now_peer_info_t*) { return ESP_FAIL; }
+inline esp_err_t esp_now_send(const uint8_t*, const uint8_t*, size_t) { return ESP_FAIL; }
@@ -0,0 +1,11 @@
+/**
+ * Swarm Sim - esp_random() on the host (per-thread generator)
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+inline uint32_t esp_random() {
+    return simRng()();
+}
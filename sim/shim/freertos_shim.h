@@ -0,0 +1,152 @@
+/**
+ * Swarm Sim - FreeRTOS Host Shim
+ *
+ * The subset hive-core uses: critical sections, a mutex, byte-copy
+ * queues and detached tasks. Ticks are milliseconds.
+ */
+
+#pragma once
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xffffffffUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+// ============== Critical Sections ==============
+
+struct portMUX_TYPE {
+    std::recursive_mutex mutex;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux) (mux)->mutex.lock()
+#define portEXIT_CRITICAL(mux) (mux)->mutex.unlock()
+#define portENTER_CRITICAL_ISR(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux) portEXIT_CRITICAL(mux)
+
+// ============== Mutex ==============
+
+typedef std::recursive_timed_mutex* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new std::recursive_timed_mutex();
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        mutex->lock();
+        return pdTRUE;
+    }
+    return mutex->try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+    mutex->unlock();
+    return pdTRUE;
+}
+
+// ============== Queues ==============
+
+struct SimQueue {
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t itemSize;
+};
+
+typedef SimQueue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    SimQueue* queue = new SimQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->items.size() >= queue->length) return pdFALSE;
+    const uint8_t* bytes = (const uint8_t*)item;
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    queue->ready.notify_one();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (queue->items.empty() && ticks > 0) {
+        queue->ready.wait_for(lock, std::chrono::milliseconds(ticks), [queue] { return !queue->items.empty(); });
+    }
+    if (queue->items.empty()) return pdFALSE;
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    return pdTRUE;
+}
+
+// ============== Tasks ==============
+
+// Tasks are detached threads: they do NOT see the creating bee's
+// thread_local globals, so sim bees keep their work on the bee thread
+typedef std::thread::id* TaskHandle_t;
+
+inline BaseType_t xTaskCreate(void (*task)(void*), const char*, uint32_t, void* param, UBaseType_t,
+                              TaskHandle_t* handle) {
+    std::thread(task, param).detach();
+    if (handle) *handle = nullptr;
+    return pdPASS;
+}
+
+inline TickType_t xTaskGetTickCount() {
+    return (TickType_t)millis();
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    delay(ticks);
+}
+
+inline void vTaskDelayUntil(TickType_t* lastWake, TickType_t period) {
+    *lastWake += period;
+    int32_t wait = (int32_t)(*lastWake - xTaskGetTickCount());
+    if (wait > 0) delay((unsigned long)wait);
+}
+
+inline void vTaskDelete(TaskHandle_t) {}
+
+// Each bee thread stands in for the task it runs (HIVE_PERF builds)
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    static thread_local std::thread::id id = std::this_thread::get_id();
+    return &id;
+}
+
+inline const char* pcTaskGetName(TaskHandle_t) {
+    return "bee";
+}
+
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) {
+    return 0;  // No stack watermark on the host
+}
+
+// ============== Memory ==============
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+inline void* heap_caps_malloc(size_t size, uint32_t) {
+    return malloc(size);
+}
+
+inline void heap_caps_free(void* ptr) {
+    free(ptr);
+}
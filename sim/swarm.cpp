@@ -0,0 +1,682 @@
+/**
+ * Swarm Sim - Fleet Load Test
+ *
+ * Hundreds of simulated bees in one process, on the real hive-core, against
+ * a real broker (env:native-swarm). Every bee is a thread with its own
+ * HiveCore, MQTT session, LWT, log ring and publish arena - the core's
+ * globals are HIVE_PER_BEE - so the broker and hub see a real fleet:
+ * discovery, availability, health every 5 s, logs, state and events.
+ *
+ *   pio run -e native-swarm
+ *   .pio/build/native-swarm/program --broker 192.168.0.95 --bees 200 --rate 0.5 --duration 120
+ *
+ * Personalities follow the worker bees' MQTT contracts:
+ * - tinybee: switch events on .../switch (outbox + .../replay while offline),
+ *   powerSwitch command -> state
+ * - bedlift: bedLift raise/lower/stop -> timed lift, state on start/stop
+ *
+ * A controller connection (standing in for the hub) subscribes to all
+ * events and state and sends commands, and reports every --report seconds:
+ * - uplink: bee publish -> controller receive (bees stamp "sent_us")
+ * - command: controller publish -> bee state showing the result
+ * - throughput, online bees, time to first CONNACK
+ * The run ends with one "SWARM {json}" line for scripts.
+ *
+ * Topics default to the "swarm" prefix so the hub and Home Assistant leave
+ * the simulated fleet alone; IDs are stable per --bees index, so reruns
+ * overwrite the same retained topics.
+ */
+
+#include <HiveCore.h>
+
+#include <esp_random.h>
+#include <signal.h>
+
+// ============== Options ==============
+
+struct SwarmOptions {
+    String broker = HIVE_DEFAULT_MQTT_SERVER;  // host[:port][,host[:port]] like mqttServer
+    int port = HIVE_DEFAULT_MQTT_PORT;
+    String prefix = "swarm";
+    int bees = 100;
+    int bedliftPercent = 20;       // The rest are tinybees
+    float rate = 0.2f;             // Switch events per tinybee per second
+    float commands = 5.0f;         // Commands per second across the swarm
+    int ramp = 50;                 // Bees started per second
+    int duration = 60;             // Seconds after the last bee started (0 = until Ctrl-C)
+    int report = 5;                // Seconds between report lines
+    bool verbose = false;          // Bee Serial output
+} options;
+
+static void usage() {
+    printf("Usage: program [options]\n"
+           "  --broker HOST[:PORT][,...]  broker list, as in the bee config (default %s)\n"
+           "  --port N                    default port (default %d)\n"
+           "  --prefix TOPIC              topic prefix (default swarm)\n"
+           "  --bees N                    simulated bees (default 100)\n"
+           "  --bedlift PERCENT           share of bedlift bees, rest tinybee (default 20)\n"
+           "  --rate R                    switch events per tinybee per second (default 0.2)\n"
+           "  --commands R                commands per second across the swarm (default 5)\n"
+           "  --ramp N                    bees started per second (default 50)\n"
+           "  --duration S                run time after ramp-up, 0 = until Ctrl-C (default 60)\n"
+           "  --report S                  seconds between reports (default 5)\n"
+           "  --verbose                   print every bee's Serial output\n",
+           HIVE_DEFAULT_MQTT_SERVER, HIVE_DEFAULT_MQTT_PORT);
+}
+
+static bool parseOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--verbose") options.verbose = true;
+        else if (arg == "--help" || arg == "-h") return false;
+        else if (!hasValue) return false;
+        else if (arg == "--broker") options.broker = argv[++i];
+        else if (arg == "--port") options.port = atoi(argv[++i]);
+        else if (arg == "--prefix") options.prefix = argv[++i];
+        else if (arg == "--bees") options.bees = atoi(argv[++i]);
+        else if (arg == "--bedlift") options.bedliftPercent = atoi(argv[++i]);
+        else if (arg == "--rate") options.rate = atof(argv[++i]);
+        else if (arg == "--commands") options.commands = atof(argv[++i]);
+        else if (arg == "--ramp") options.ramp = atoi(argv[++i]);
+        else if (arg == "--duration") options.duration = atoi(argv[++i]);
+        else if (arg == "--report") options.report = atoi(argv[++i]);
+        else return false;
+    }
+    return options.bees > 0 && options.ramp > 0 && options.report > 0;
+}
+
+// ============== Shared Stats ==============
+
+#define SWARM_LOOP_MS 2              // Bee loop period
+#define SWARM_COMMAND_TIMEOUT 5000   // Command without a matching state = lost (ms)
+#define SWARM_MAX_SAMPLES 200000     // Reservoir per latency series
+#define SWARM_LIFT_MS 8000           // Full travel, bottom to top
+
+enum SwarmKind { SWARM_TINYBEE, SWARM_BEDLIFT };
+
+struct SwarmBee {
+    int index;
+    SwarmKind kind;
+    String id;
+    std::thread thread;
+    std::atomic<bool> online{false};
+};
+
+static std::vector<SwarmBee*> swarm;
+static std::atomic<bool> stopping{false};
+
+static std::atomic<uint32_t> beesOnline{0};
+static std::atomic<uint32_t> connects{0};
+static std::atomic<uint32_t> disconnects{0};
+static std::atomic<uint32_t> eventsSent{0};
+static std::atomic<uint32_t> eventsQueued{0};   // Offline: outbox, replayed on reconnect
+static std::atomic<uint32_t> commandsHandled{0};
+
+// Latency samples in us; reservoir-sampled past SWARM_MAX_SAMPLES
+class LatencySeries {
+public:
+    void add(uint32_t us) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _count++;
+        if (_samples.size() < SWARM_MAX_SAMPLES) {
+            _samples.push_back(us);
+        } else {
+            uint64_t slot = simRng()() % _count;
+            if (slot < SWARM_MAX_SAMPLES) _samples[slot] = us;
+        }
+        if (us > _max) _max = us;
+    }
+
+    // p50/p95/p99/max in ms, and resets if asked (report windows)
+    void json(JsonObject out, bool reset) {
+        std::vector<uint32_t> samples;
+        uint64_t count;
+        uint32_t max;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            samples = _samples;
+            count = _count;
+            max = _max;
+            if (reset) {
+                _samples.clear();
+                _count = 0;
+                _max = 0;
+            }
+        }
+        out["count"] = count;
+        if (samples.empty()) return;
+        std::sort(samples.begin(), samples.end());
+        out["p50_ms"] = percentile(samples, 50) / 1000.0f;
+        out["p95_ms"] = percentile(samples, 95) / 1000.0f;
+        out["p99_ms"] = percentile(samples, 99) / 1000.0f;
+        out["max_ms"] = max / 1000.0f;
+    }
+
+private:
+    static uint32_t percentile(const std::vector<uint32_t>& sorted, int pct) {
+        size_t rank = (sorted.size() - 1) * pct / 100;
+        return sorted[rank];
+    }
+
+    std::mutex _mutex;
+    std::vector<uint32_t> _samples;
+    uint64_t _count = 0;
+    uint32_t _max = 0;
+};
+
+static LatencySeries connectLatency;   // Bee start -> first CONNACK
+static LatencySeries uplinkLatency;    // Bee publish -> controller
+static LatencySeries commandLatency;   // Controller command -> bee state
+static LatencySeries uplinkWindow;
+static LatencySeries commandWindow;
+
+// ============== Bee: Shared ==============
+
+// Hooks are plain function pointers, so per-bee state is thread_local like the core's
+static thread_local SwarmBee* self = nullptr;
+static thread_local unsigned long beeStartedUs = 0;
+static thread_local bool beeEverConnected = false;
+
+static void onBeeConnect(bool sessionPresent) {
+    if (!beeEverConnected) {
+        beeEverConnected = true;
+        connectLatency.add(micros() - beeStartedUs);
+    }
+    connects++;
+    beesOnline++;
+    self->online = true;
+}
+
+static void onBeeDisconnect(espMqttClientTypes::DisconnectReason reason) {
+    if (!self->online) return;  // Failed attempt, not a drop
+    self->online = false;
+    beesOnline--;
+    disconnects++;
+}
+
+// Exponential gaps for a Poisson stream of `rate` events per second
+static unsigned long nextGapMs(float rate) {
+    if (rate <= 0) return ULONG_MAX / 2;
+    std::exponential_distribution<float> gap(rate);
+    return (unsigned long)(gap(simRng()) * 1000.0f) + 1;
+}
+
+// ============== Bee: TinyBee ==============
+
+#define TINYBEE_SWITCHES 4  // Toggles only; the start button would fire love bombs
+
+static const char* tinySwitchNames[TINYBEE_SWITCHES] = {"switch1", "switch2", "switch3", "switch4"};
+static const char* tinySwitchLabels[TINYBEE_SWITCHES] = {"Switch 1", "Switch 2", "Switch 3", "Switch 4"};
+
+struct TinyBeeState {
+    bool ledOn = false;
+    bool switches[TINYBEE_SWITCHES] = {};
+    String switchTopic;
+    unsigned long nextEvent = 0;
+};
+
+static thread_local TinyBeeState tiny;
+
+static void tinyPowerSwitch(const char* instance, JsonObject capability, JsonDocument& doc) {
+    int value = capability["value"];
+    tiny.ledOn = (value == 1);
+    commandsHandled++;
+    hive.publishState();
+}
+
+static const HiveCommand tinyCommands[] = {
+    {"powerSwitch", tinyPowerSwitch},
+};
+
+static void tinyDiscovery(JsonDocument& doc) {
+    JsonArray capabilities = doc["capabilities"].to<JsonArray>();
+    JsonObject ledCap = capabilities.add<JsonObject>();
+    ledCap["type"] = "devices.capabilities.on_off";
+    ledCap["instance"] = "powerSwitch";
+    for (int i = 0; i < TINYBEE_SWITCHES; i++) {
+        JsonObject swCap = capabilities.add<JsonObject>();
+        swCap["type"] = "devices.capabilities.binary_sensor";
+        swCap["instance"] = tinySwitchNames[i];
+        swCap["name"] = tinySwitchLabels[i];
+    }
+}
+
+static void tinyState(JsonDocument& doc) {
+    doc["powerSwitch"] = tiny.ledOn ? 1 : 0;
+    JsonObject switches = doc["switches"].to<JsonObject>();
+    for (int i = 0; i < TINYBEE_SWITCHES; i++) {
+        switches[tinySwitchNames[i]] = tiny.switches[i] ? 1 : 0;
+    }
+    doc["sent_us"] = (uint32_t)micros();
+}
+
+static void tinyLoop() {
+    // Keeps flipping through outages so the outbox/replay path gets load too
+    if (millis() < tiny.nextEvent) return;
+    tiny.nextEvent = millis() + nextGapMs(options.rate);
+
+    int index = random(TINYBEE_SWITCHES);
+    bool isOn = tiny.switches[index] = !tiny.switches[index];
+
+    // Same payload as tinybee's publishSwitchChange(), plus the send stamp
+    HiveMessage msg;
+    msg.doc["switch"] = tinySwitchNames[index];
+    msg.doc["label"] = tinySwitchLabels[index];
+    msg.doc["state"] = isOn ? "on" : "off";
+    msg.doc["value"] = isOn ? 1 : 0;
+    msg.doc["timestamp"] = millis();
+    msg.doc["sent_us"] = (uint32_t)micros();
+    if (msg.publishEvent(tiny.switchTopic.c_str())) {
+        eventsSent++;
+    } else {
+        eventsQueued++;
+    }
+}
+
+// ============== Bee: BedLift ==============
+
+struct BedLiftState {
+    bool isLifting = false;
+    String direction;
+    String lastStopReason;
+    float position = 0;            // 0-100
+    unsigned long lastStep = 0;
+};
+
+static thread_local BedLiftState lift;
+
+static void liftStop(const char* reason) {
+    if (lift.isLifting) lift.lastStopReason = reason;
+    lift.isLifting = false;
+    lift.direction = "";
+    hive.publishState();
+}
+
+static void liftBedLift(const char* instance, JsonObject capability, JsonDocument& doc) {
+    const char* value = capability["value"];
+    if (!value) return;
+    commandsHandled++;
+
+    switch (hiveHash(value)) {
+        case hiveHash("raise"):
+        case hiveHash("lower"):
+            lift.isLifting = true;
+            lift.direction = value;
+            lift.lastStopReason = "";
+            lift.lastStep = millis();
+            hive.publishState();
+            break;
+        case hiveHash("stop"):
+            liftStop("manual");
+            break;
+    }
+}
+
+static const HiveCommand liftCommands[] = {
+    {"bedLift", liftBedLift},
+};
+
+static void liftDiscovery(JsonDocument& doc) {
+    JsonArray capabilities = doc["capabilities"].to<JsonArray>();
+    JsonObject liftCap = capabilities.add<JsonObject>();
+    liftCap["type"] = "devices.capabilities.mode";
+    liftCap["instance"] = "bedLift";
+    doc["sensors"] = JsonArray();
+}
+
+static void liftState(JsonDocument& doc) {
+    doc["isLifting"] = lift.isLifting;
+    doc["direction"] = lift.direction.c_str();
+    doc["positionPercent"] = (int)lift.position;
+    doc["lastStopReason"] = lift.lastStopReason.c_str();
+    doc["sent_us"] = (uint32_t)micros();
+}
+
+static void liftLoop() {
+    if (!lift.isLifting) return;
+
+    unsigned long now = millis();
+    float step = (now - lift.lastStep) * 100.0f / SWARM_LIFT_MS;
+    lift.lastStep = now;
+    lift.position += lift.direction == "raise" ? step : -step;
+
+    if (lift.position >= 100) {
+        lift.position = 100;
+        liftStop("limit");
+    } else if (lift.position <= 0) {
+        lift.position = 0;
+        liftStop("limit");
+    }
+}
+
+// ============== Bee Thread ==============
+
+static void beeMain(SwarmBee* bee) {
+    self = bee;
+    beeStartedUs = micros();
+
+    // Device ID comes from the MAC: 5357 ("SW"), kind, index
+    ESP.efuseMac = ((uint64_t)0x5357 << 32) | ((uint64_t)bee->kind << 24) | (uint32_t)bee->index;
+
+    bool bedlift = bee->kind == SWARM_BEDLIFT;
+    const HiveDeviceInfo info = bedlift
+        ? HiveDeviceInfo{"bedliftbee", "Swarm BedLift", "swarm-1.0.0", "swarm"}
+        : HiveDeviceInfo{"tinybee", "Swarm TinyBee", "swarm-1.0.0", "swarm"};
+    hive.begin(info);
+    bee->id = hive.deviceId();
+    snprintf(simSerialPrefix, sizeof(simSerialPrefix), "[%s] ", bee->id.c_str());
+
+    HiveConfig config = {};
+    snprintf(config.deviceName, sizeof(config.deviceName), "Swarm %s %d", bedlift ? "BedLift" : "TinyBee",
+             bee->index);
+    strlcpy(config.mqttServer, options.broker.c_str(), sizeof(config.mqttServer));
+    config.mqttPort = options.port;
+    strlcpy(config.topicPrefix, options.prefix.c_str(), sizeof(config.topicPrefix));
+
+    hive.onConnect(onBeeConnect);
+    hive.onDisconnect(onBeeDisconnect);
+    if (bedlift) hive.onCommands(liftCommands);
+    else hive.onCommands(tinyCommands);
+    hive.onDiscovery(bedlift ? liftDiscovery : tinyDiscovery);
+    hive.onState(bedlift ? liftState : tinyState);
+    hive.setupMQTT(config);
+    tiny.switchTopic = hive.topicFor(bee->id.c_str(), "switch");
+    tiny.nextEvent = millis() + nextGapMs(options.rate);
+
+    while (!stopping) {
+        hive.loop();
+        if (bedlift) liftLoop();
+        else tinyLoop();
+        delay(SWARM_LOOP_MS);
+    }
+
+    // Leave the broker tidy: "offline" now rather than the LWT after the keep-alive
+    if (hive.mqttConnected()) {
+        mqttClient.publish(hive.topics().availability.c_str(), 1, true, "offline");
+        unsigned long started = millis();
+        while (mqttClient.queueSize() > 0 && millis() - started < 2000) {
+            mqttClient.loop();
+            delay(SWARM_LOOP_MS);
+        }
+        mqttClient.disconnect();
+    }
+}
+
+// ============== Controller ==============
+
+// One connection like the hub's; its callbacks run on the main thread
+static espMqttClient controller;
+static std::atomic<bool> controllerOnline{false};
+
+struct PendingCommand {
+    unsigned long sentUs = 0;      // 0 = none in flight
+    int expectLed = -1;            // tinybee: powerSwitch value
+    const char* expectDirection = nullptr;  // bedlift: direction, "" = stopped
+};
+
+struct BeeView {
+    PendingCommand pending;
+    bool ledOn = false;
+    bool isLifting = false;
+};
+
+static std::vector<BeeView> views;
+static uint32_t messagesReceived = 0;
+static uint64_t bytesReceived = 0;
+static uint32_t commandsSent = 0;
+static uint32_t commandsLost = 0;
+
+// ".../devices/<id>/<leaf>" -> bee index from the ID's low bytes
+static int beeIndexFor(const char* topic, const char** leaf) {
+    const char* devices = strstr(topic, "/devices/");
+    if (!devices) return -1;
+    const char* id = devices + strlen("/devices/");
+    const char* slash = strchr(id, '/');
+    if (!slash || slash - id != 12 || strncmp(id, "5357", 4) != 0) return -1;
+    *leaf = slash + 1;
+    int index = (int)strtoul(std::string(id + 6, 6).c_str(), nullptr, 16);
+    return index < (int)views.size() ? index : -1;
+}
+
+static void onControllerMessage(const espMqttClientTypes::MessageProperties& properties, const char* topic,
+                                const uint8_t* payload, size_t len, size_t index, size_t total) {
+    uint32_t now = micros();
+    messagesReceived++;
+    bytesReceived += len;
+
+    const char* leaf = nullptr;
+    int bee = beeIndexFor(topic, &leaf);
+    if (bee < 0 || properties.retain) return;  // Retained = from before this run
+
+    JsonDocument doc;
+    if (deserializeJson(doc, payload, len)) return;
+    if (!doc["sent_us"].is<uint32_t>()) return;
+
+    uint32_t latency = now - doc["sent_us"].as<uint32_t>();
+    uplinkLatency.add(latency);
+    uplinkWindow.add(latency);
+
+    if (strcmp(leaf, "state") != 0) return;
+    BeeView& view = views[bee];
+    view.ledOn = doc["powerSwitch"] | 0;
+    view.isLifting = doc["isLifting"] | false;
+
+    PendingCommand& pending = view.pending;
+    if (!pending.sentUs) return;
+    bool done = pending.expectLed >= 0
+        ? (int)view.ledOn == pending.expectLed
+        : strcmp(doc["direction"] | "", pending.expectDirection) == 0;
+    if (!done) return;
+
+    uint32_t roundTrip = now - pending.sentUs;
+    commandLatency.add(roundTrip);
+    commandWindow.add(roundTrip);
+    pending = {};
+}
+
+static void onControllerConnect(bool sessionPresent) {
+    controller.subscribe((options.prefix + "/devices/+/switch").c_str(), 0);
+    controller.subscribe((options.prefix + "/devices/+/state").c_str(), 0);
+    controllerOnline = true;
+}
+
+static void onControllerDisconnect(espMqttClientTypes::DisconnectReason reason) {
+    controllerOnline = false;
+}
+
+static bool setupController() {
+    // First broker of the list; the bees do their own failover
+    char host[64];
+    strlcpy(host, options.broker.c_str(), sizeof(host));
+    host[strcspn(host, ", ")] = '\0';
+    int port = options.port;
+    char* colon = strchr(host, ':');
+    if (colon) {
+        *colon = '\0';
+        port = atoi(colon + 1);
+    }
+
+    static char clientId[32];
+    snprintf(clientId, sizeof(clientId), "swarm-controller-%u", (unsigned)(esp_random() & 0xffff));
+    controller.onConnect(onControllerConnect);
+    controller.onDisconnect(onControllerDisconnect);
+    controller.onMessage(onControllerMessage);
+    controller.setClientId(clientId);
+    controller.setCleanSession(true);
+    controller.setKeepAlive(HIVE_KEEP_ALIVE);
+    controller.setServer(host, port);
+    controller.connect();
+
+    unsigned long started = millis();
+    while (!controllerOnline && millis() - started < HIVE_BROKER_CONNECT_TIMEOUT) {
+        controller.loop();
+        delay(SWARM_LOOP_MS);
+    }
+    if (!controllerOnline) fprintf(stderr, "[SWARM] Controller could not reach %s:%d\n", host, port);
+    return controllerOnline;
+}
+
+static void sendCommand() {
+    int index = random(swarm.size());
+    SwarmBee* bee = swarm[index];
+    BeeView& view = views[index];
+    if (!bee->online || view.pending.sentUs) return;  // Try again next tick
+
+    JsonDocument doc;
+    JsonObject capability = doc["capability"].to<JsonObject>();
+    PendingCommand pending;
+    if (bee->kind == SWARM_TINYBEE) {
+        pending.expectLed = view.ledOn ? 0 : 1;
+        capability["instance"] = "powerSwitch";
+        capability["value"] = pending.expectLed;
+    } else {
+        const char* value = view.isLifting ? "stop" : (random(2) ? "raise" : "lower");
+        pending.expectDirection = view.isLifting ? "" : value;
+        capability["instance"] = "bedLift";
+        capability["value"] = value;
+    }
+
+    char payload[128];
+    size_t len = serializeJson(doc, payload, sizeof(payload));
+    String topic = options.prefix + "/devices/" + bee->id + "/set";
+    pending.sentUs = micros();
+    if (controller.publish(topic.c_str(), 1, false, (const uint8_t*)payload, len)) {
+        view.pending = pending;
+        commandsSent++;
+    }
+}
+
+static void expireCommands() {
+    uint32_t now = micros();
+    for (BeeView& view : views) {
+        if (view.pending.sentUs && now - view.pending.sentUs > SWARM_COMMAND_TIMEOUT * 1000UL) {
+            view.pending = {};
+            commandsLost++;
+        }
+    }
+}
+
+// ============== Reports ==============
+
+static void printLatency(const char* name, LatencySeries& series) {
+    JsonDocument doc;
+    series.json(doc.to<JsonObject>(), true);
+    if (!doc["p50_ms"].is<float>()) {
+        printf(" | %s -", name);
+        return;
+    }
+    printf(" | %s p50 %.1f p95 %.1f p99 %.1f max %.1f ms", name, doc["p50_ms"].as<float>(),
+           doc["p95_ms"].as<float>(), doc["p99_ms"].as<float>(), doc["max_ms"].as<float>());
+}
+
+static void printReport(unsigned long elapsedMs, uint32_t messages, uint32_t events, uint32_t windowMs) {
+    printf("[SWARM] %4lus online %u/%d | rx %.0f msg/s | events %.1f/s", elapsedMs / 1000,
+           beesOnline.load(), options.bees, messages * 1000.0f / windowMs, events * 1000.0f / windowMs);
+    printLatency("uplink", uplinkWindow);
+    printLatency("command", commandWindow);
+    printf(" | lost %u\n", commandsLost);
+    fflush(stdout);
+}
+
+static void printSummary(unsigned long elapsedMs) {
+    JsonDocument doc;
+    doc["bees"] = options.bees;
+    doc["bedlift_percent"] = options.bedliftPercent;
+    doc["seconds"] = elapsedMs / 1000.0f;
+    doc["online"] = beesOnline.load();
+    doc["connects"] = connects.load();
+    doc["disconnects"] = disconnects.load();
+    doc["events_sent"] = eventsSent.load();
+    doc["events_queued"] = eventsQueued.load();
+    doc["messages_received"] = messagesReceived;
+    doc["rx_msg_per_s"] = elapsedMs > 0 ? messagesReceived * 1000.0f / elapsedMs : 0;
+    doc["rx_bytes_per_s"] = elapsedMs > 0 ? bytesReceived * 1000.0f / elapsedMs : 0;
+    doc["commands_sent"] = commandsSent;
+    doc["commands_handled"] = commandsHandled.load();
+    doc["commands_lost"] = commandsLost;
+    connectLatency.json(doc["connect"].to<JsonObject>(), false);
+    uplinkLatency.json(doc["uplink"].to<JsonObject>(), false);
+    commandLatency.json(doc["command"].to<JsonObject>(), false);
+
+    char line[1024];
+    serializeJson(doc, line, sizeof(line));
+    printf("SWARM %s\n", line);
+}
+
+// ============== Main ==============
+
+static void onSignal(int) {
+    stopping = true;
+}
+
+int main(int argc, char** argv) {
+    if (!parseOptions(argc, argv)) {
+        usage();
+        return 2;
+    }
+    simSerialEnabled = options.verbose;
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    printf("[SWARM] %d bees (%d%% bedlift) -> %s, prefix %s\n", options.bees, options.bedliftPercent,
+           options.broker.c_str(), options.prefix.c_str());
+    if (!setupController()) return 1;
+
+    views.resize(options.bees);
+    int bedlifts = options.bees * options.bedliftPercent / 100;
+
+    unsigned long started = millis();
+    unsigned long lastReport = started;
+    unsigned long lastCommand = started;
+    unsigned long rampDone = 0;
+    uint32_t lastMessages = 0;
+    uint32_t lastEvents = 0;
+    float commandCredit = 0;
+
+    while (!stopping) {
+        unsigned long now = millis();
+
+        // Staggered start, --ramp bees per second (bedlifts spread through the fleet)
+        size_t due = std::min((size_t)options.bees, (size_t)((now - started) * options.ramp / 1000 + 1));
+        while (swarm.size() < due) {
+            SwarmBee* bee = new SwarmBee();
+            bee->index = (int)swarm.size();
+            bool bedlift = bee->index * bedlifts / options.bees != (bee->index + 1) * bedlifts / options.bees;
+            bee->kind = bedlift ? SWARM_BEDLIFT : SWARM_TINYBEE;
+            swarm.push_back(bee);
+            bee->thread = std::thread(beeMain, bee);
+        }
+        if (!rampDone && swarm.size() == (size_t)options.bees) rampDone = now;
+
+        controller.loop();
+        if (controllerOnline) {
+            commandCredit += (now - lastCommand) * options.commands / 1000.0f;
+            while (commandCredit >= 1) {
+                sendCommand();
+                commandCredit -= 1;
+            }
+        } else if (controller.disconnected()) {
+            controller.connect();
+        }
+        lastCommand = now;
+        expireCommands();
+
+        if (now - lastReport >= (unsigned long)options.report * 1000) {
+            printReport(now - started, messagesReceived - lastMessages, eventsSent - lastEvents, now - lastReport);
+            lastReport = now;
+            lastMessages = messagesReceived;
+            lastEvents = eventsSent;
+        }
+
+        if (rampDone && options.duration > 0 && now - rampDone >= (unsigned long)options.duration * 1000) break;
+        delay(1);
+    }
+
+    stopping = true;
+    for (SwarmBee* bee : swarm) bee->thread.join();
+    controller.disconnect();
+
+    printSummary(millis() - started);
+    return 0;
+}
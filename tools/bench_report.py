@@ -0,0 +1,88 @@
+"""
+Collect on-target benchmark results (HIVE_BENCH builds).
+
+Reads a serial log on stdin, picks out the "BENCH {...}" lines printed by
+lib/hive-core/src/HiveBench.cpp and prints one row per benchmark:
+
+    pio device monitor -e kaycibee-bench | python3 tools/bench_report.py
+
+Save a run and compare the next release against it (exit code 1 if any
+benchmark got slower than --tolerance, is over its on-device budget or
+produced a payload too large to publish):
+
+    python3 tools/bench_report.py --save bench-3.2.0.json < run.log
+    python3 tools/bench_report.py --baseline bench-3.2.0.json < run.log
+"""
+
+import argparse
+import json
+import sys
+
+
+def read_run(stream):
+    run = {"header": {}, "results": {}}
+    for line in stream:
+        start = line.find("BENCH {")
+        if start < 0:
+            continue
+        try:
+            record = json.loads(line[start + len("BENCH "):])
+        except ValueError:
+            continue
+        if "name" in record:
+            run["results"][record["name"]] = record
+        elif "firmware" in record:
+            run = {"header": record, "results": {}}  # Device rebooted: new run
+        elif record.get("done"):
+            break
+    return run
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--save", help="write this run as JSON")
+    parser.add_argument("--baseline", help="JSON from an earlier --save to compare against")
+    parser.add_argument("--tolerance", type=float, default=10.0, help="allowed slowdown in %% (default 10)")
+    args = parser.parse_args()
+
+    run = read_run(sys.stdin)
+    if not run["results"]:
+        print("No BENCH lines found", file=sys.stderr)
+        return 2
+
+    baseline = {}
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)["results"]
+
+    header = run["header"]
+    print("%s %s @ %s MHz" % (header.get("type", "?"), header.get("firmware", "?"), header.get("cpu_mhz", "?")))
+    print("%-22s %8s %8s %8s %8s  %s" % ("benchmark", "avg_us", "min_us", "max_us", "budget", "vs baseline"))
+
+    failed = False
+    for name, result in run["results"].items():
+        note = ""
+        if not result.get("ok", True):
+            if result.get("bytes", 0) > result.get("max_bytes", 0) > 0:
+                note = "TOO LARGE (%d > %d bytes)" % (result["bytes"], result["max_bytes"])
+            else:
+                note = "OVER BUDGET"
+            failed = True
+        if name in baseline and baseline[name]["avg_us"] > 0:
+            change = (result["avg_us"] - baseline[name]["avg_us"]) * 100.0 / baseline[name]["avg_us"]
+            note = ("%+.1f%% " % change + note).strip()
+            if change > args.tolerance:
+                note += " REGRESSION"
+                failed = True
+        print("%-22s %8d %8d %8d %8s  %s" % (name, result["avg_us"], result["min_us"], result["max_us"],
+                                            result.get("budget_us") or "-", note))
+
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump(run, f, indent=2)
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
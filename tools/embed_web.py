@@ -0,0 +1,92 @@
+"""
+Embed bee web UIs into the firmware.
+
+Gzips every file in web/<bee>/ and writes include/web/<bee>.h with one
+HiveWebAsset per file (see lib/hive-core/src/HiveWeb.h). Runs before each
+PlatformIO build via `extra_scripts = pre:tools/embed_web.py`, or by hand:
+
+    python3 tools/embed_web.py
+
+Headers are only rewritten when their content changes, so unchanged pages
+don't trigger a rebuild.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+MIME_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+}
+
+
+def symbol_for(filename):
+    return "WEB_" + re.sub(r"[^A-Za-z0-9]", "_", filename).upper()
+
+
+def render_header(bee, web_dir):
+    lines = [
+        "// Generated by tools/embed_web.py from web/%s - do not edit" % bee,
+        "#pragma once",
+        "",
+        "#include <HiveWeb.h>",
+        "",
+    ]
+    for filename in sorted(os.listdir(web_dir)):
+        path = os.path.join(web_dir, filename)
+        if not os.path.isfile(path) or filename.startswith("."):
+            continue
+
+        with open(path, "rb") as f:
+            raw = f.read()
+        # mtime=0 keeps the output (and the ETag) identical across builds
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = '\\"%s\\"' % hashlib.sha1(raw).hexdigest()[:16]
+        mime = MIME_TYPES.get(os.path.splitext(filename)[1].lower(), "application/octet-stream")
+        symbol = symbol_for(filename)
+
+        lines.append("// %s: %d bytes, %d gzipped" % (filename, len(raw), len(packed)))
+        lines.append("static const uint8_t %s_GZ[] PROGMEM = {" % symbol)
+        for i in range(0, len(packed), 16):
+            lines.append("    " + ", ".join("0x%02x" % b for b in packed[i:i + 16]) + ",")
+        lines.append("};")
+        lines.append('static const HiveWebAsset %s = {"%s", %s_GZ, sizeof(%s_GZ), "%s"};'
+                     % (symbol, mime, symbol, symbol, etag))
+        lines.append("")
+    return "\n".join(lines)
+
+
+def embed_all(project_dir):
+    web_root = os.path.join(project_dir, "web")
+    out_dir = os.path.join(project_dir, "include", "web")
+    if not os.path.isdir(web_root):
+        return
+    os.makedirs(out_dir, exist_ok=True)
+
+    for bee in sorted(os.listdir(web_root)):
+        web_dir = os.path.join(web_root, bee)
+        if not os.path.isdir(web_dir):
+            continue
+
+        header = render_header(bee, web_dir)
+        out_path = os.path.join(out_dir, bee + ".h")
+        if os.path.exists(out_path):
+            with open(out_path) as f:
+                if f.read() == header:
+                    continue
+        with open(out_path, "w") as f:
+            f.write(header)
+        print("[embed_web] %s -> include/web/%s.h" % (bee, bee))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    embed_all(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    embed_all(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
@@ -39,6 +39,70 @@ interface BrokerConfig {
 
 type DeviceUpdateListener = (devices: ESP32DeviceWithBroker[]) => void;
 
+// Delta health telemetry (hive-core HiveTelemetry.h): seq/kf are present
+// when a bee runs in delta or msgpack mode
+type HealthUpdate = Partial<ESP32Health> & { seq?: number; kf?: boolean };
+
+// Minimal MessagePack decoder for .../health/msgpack (maps, arrays, scalars)
+function decodeMsgPack(buf: Buffer): unknown {
+  let pos = 0;
+
+  const str = (len: number) => {
+    const value = buf.toString('utf8', pos, pos + len);
+    pos += len;
+    return value;
+  };
+  const array = (len: number) => {
+    const out: unknown[] = [];
+    for (let i = 0; i < len; i++) out.push(read());
+    return out;
+  };
+  const map = (len: number) => {
+    const out: Record<string, unknown> = {};
+    for (let i = 0; i < len; i++) {
+      const key = String(read());
+      out[key] = read();
+    }
+    return out;
+  };
+
+  function read(): unknown {
+    const b = buf[pos++];
+    if (b <= 0x7f) return b;
+    if (b >= 0xe0) return b - 0x100;
+    if ((b & 0xf0) === 0x80) return map(b & 0x0f);
+    if ((b & 0xf0) === 0x90) return array(b & 0x0f);
+    if ((b & 0xe0) === 0xa0) return str(b & 0x1f);
+
+    let value: unknown;
+    switch (b) {
+      case 0xc0: return null;
+      case 0xc2: return false;
+      case 0xc3: return true;
+      case 0xca: value = buf.readFloatBE(pos); pos += 4; return value;
+      case 0xcb: value = buf.readDoubleBE(pos); pos += 8; return value;
+      case 0xcc: return buf[pos++];
+      case 0xcd: value = buf.readUInt16BE(pos); pos += 2; return value;
+      case 0xce: value = buf.readUInt32BE(pos); pos += 4; return value;
+      case 0xcf: value = Number(buf.readBigUInt64BE(pos)); pos += 8; return value;
+      case 0xd0: return buf.readInt8(pos++);
+      case 0xd1: value = buf.readInt16BE(pos); pos += 2; return value;
+      case 0xd2: value = buf.readInt32BE(pos); pos += 4; return value;
+      case 0xd3: value = Number(buf.readBigInt64BE(pos)); pos += 8; return value;
+      case 0xd9: return str(buf[pos++]);
+      case 0xda: { const len = buf.readUInt16BE(pos); pos += 2; return str(len); }
+      case 0xdb: { const len = buf.readUInt32BE(pos); pos += 4; return str(len); }
+      case 0xdc: { const len = buf.readUInt16BE(pos); pos += 2; return array(len); }
+      case 0xdd: { const len = buf.readUInt32BE(pos); pos += 4; return array(len); }
+      case 0xde: { const len = buf.readUInt16BE(pos); pos += 2; return map(len); }
+      case 0xdf: { const len = buf.readUInt32BE(pos); pos += 4; return map(len); }
+      default: throw new Error(`Unsupported MessagePack type 0x${b.toString(16)}`);
+    }
+  }
+
+  return read();
+}
+
 // Individual broker connection
 class BrokerConnection {
   public id: string;
@@ -92,6 +156,7 @@ class BrokerConnection {
         `${this.topicPrefix}/devices/+/state`,
         `${this.topicPrefix}/devices/+/availability`,
         `${this.topicPrefix}/devices/+/health`,
+        `${this.topicPrefix}/devices/+/health/msgpack`,
         `${this.topicPrefix}/devices/+/logs`,
       ];
 
@@ -107,7 +172,16 @@ class BrokerConnection {
     });
 
     this.client.on('message', (topic, payload) => {
-      const payloadStr = payload.toString();
+      // Binary health is turned into JSON here so the rest of the pipeline is unchanged
+      let payloadStr: string;
+      try {
+        payloadStr = topic.endsWith('/health/msgpack')
+          ? JSON.stringify(decodeMsgPack(payload))
+          : payload.toString();
+      } catch (error) {
+        console.error(`[MQTT:${this.id}] Bad MessagePack on ${topic}:`, error);
+        return;
+      }
       this.addRawMessage(topic, payloadStr);
       this.onMessage(this.id, topic, payloadStr);
     });
@@ -259,13 +333,15 @@ class MultiBrokerMQTTService {
           });
         }
 
-      } else if (topic.includes('/devices/') && topic.endsWith('/health')) {
+      } else if (topic.includes('/devices/') && (topic.endsWith('/health') || topic.endsWith('/health/msgpack'))) {
         const deviceId = parts[2];
-        const health = JSON.parse(payload) as ESP32Health;
-        health.last_seen = Date.now();
-        health.stale = false;
-        console.log(`[MQTT:${brokerId}] Health update for ${deviceId}: mqtt=${health.mqtt_state}`);
-        this.deviceHealth.set(deviceId, health);
+        const health = this.mergeHealth(deviceId, JSON.parse(payload) as HealthUpdate);
+        if (health) {
+          health.last_seen = Date.now();
+          health.stale = false;
+          console.log(`[MQTT:${brokerId}] Health update for ${deviceId}: mqtt=${health.mqtt_state}`);
+          this.deviceHealth.set(deviceId, health);
+        }
 
         // Health = device is online on this broker
         const existing = this.devices.get(deviceId);
@@ -288,7 +364,12 @@ class MultiBrokerMQTTService {
 
       } else if (topic.includes('/devices/') && topic.endsWith('/logs')) {
         const deviceId = parts[2];
-        const logEntry = JSON.parse(payload) as { ts: number; msg: string };
+        const parsed = JSON.parse(payload) as
+          | { ts: number; msg: string }
+          | { entries: { ts: number; msg: string }[]; dropped?: number };
+
+        // hive-core batches entries; older firmware sends one line per message
+        const entries = 'entries' in parsed ? parsed.entries : [parsed];
 
         let logs = this.deviceLogs.get(deviceId);
         if (!logs) {
@@ -296,22 +377,28 @@ class MultiBrokerMQTTService {
           this.deviceLogs.set(deviceId, logs);
         }
 
-        logs.push({
-          ts: logEntry.ts,
-          msg: logEntry.msg,
-          received: Date.now(),
-        });
+        for (const logEntry of entries) {
+          logs.push({
+            ts: logEntry.ts,
+            msg: logEntry.msg,
+            received: Date.now(),
+          });
+          console.log(`[MQTT:${brokerId}] Log from ${deviceId}: ${logEntry.msg}`);
+        }
 
         if (logs.length > this.maxLogsPerDevice) {
           logs.splice(0, logs.length - this.maxLogsPerDevice);
         }
 
-        console.log(`[MQTT:${brokerId}] Log from ${deviceId}: ${logEntry.msg}`);
+        if ('entries' in parsed && parsed.dropped) {
+          console.log(`[MQTT:${brokerId}] ${deviceId} has dropped ${parsed.dropped} log lines`);
+        }
 
       } else if (topic.endsWith('/availability')) {
         const deviceId = parts[2];
-        const online = payload === 'online';
-        console.log(`[MQTT:${brokerId}] Device ${deviceId} is ${online ? 'online' : 'offline'}`);
+        // Duty-cycled bees report "sleeping" between wakes; commands queue in their session
+        const online = payload === 'online' || payload === 'sleeping';
+        console.log(`[MQTT:${brokerId}] Device ${deviceId} is ${payload}`);
 
         const existing = this.devices.get(deviceId);
         if (existing && existing.config.broker === brokerId) {
@@ -325,6 +412,21 @@ class MultiBrokerMQTTService {
     }
   }
 
+  // Rebuild a full ESP32Health record from delta telemetry. Keyframes replace
+  // the record, deltas merge into it; after a lost delta (seq gap) wait for
+  // the next keyframe rather than show a half-stale record.
+  private mergeHealth(deviceId: string, update: HealthUpdate): ESP32Health | null {
+    if (update.seq === undefined || update.kf) {
+      return update as ESP32Health;
+    }
+
+    const previous = this.deviceHealth.get(deviceId) as HealthUpdate | undefined;
+    if (!previous || previous.seq === undefined || update.seq !== previous.seq + 1) {
+      return null;
+    }
+    return { ...previous, ...update } as ESP32Health;
+  }
+
   private updateDevice(deviceId: string, update: Partial<ESP32DeviceEntry>) {
     const existing = this.devices.get(deviceId) || {
       config: { device_id: deviceId, online: true, broker: '', brokerUrl: '' } as ESP32DeviceWithBroker,
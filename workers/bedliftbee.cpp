@@ -1,1107 +1,1188 @@
-/**
- * BedLiftBee - Happy Jack Bed Lift Controller
- * ESP32-C3 Mini with 2-channel relay module + safety sensors
- *
- * Part of the Bee Colony - uses same patterns as TinyBee1/kayciBee1
- * - WiFiManager for configuration
- * - ESPAsyncWebServer for status/config
- * - espMqttClient for async MQTT
- *
- * Relays simulate pressing the rocker switch:
- * - Relay 1 (GPIO2): UP - raises the bed
- * - Relay 2 (GPIO3): DOWN - lowers the bed
- *
- * Safety Features:
- * - HC-SR04 ultrasonic sensor for distance/position tracking
- * - Reed switches for top/bottom limit detection
- * - Auto-stop when limits reached or obstacle detected
- *
- * MQTT Commands:
- * - {"capability":{"instance":"bedLift","value":"raise"}}
- * - {"capability":{"instance":"bedLift","value":"lower"}}
- * - {"capability":{"instance":"bedLift","value":"stop"}}
- * - {"capability":{"instance":"bedLift","value":"calibrate"}}
- */
-
-#include <Arduino.h>
-#include <WiFi.h>
-#include <WiFiManager.h>
-#include <espMqttClient.h>
-#include <ESPAsyncWebServer.h>
-#include <ArduinoJson.h>
-#include <Preferences.h>
-#include <ESPmDNS.h>
-#include <stdarg.h>
-
-// ============== Configuration ==============
-
-#define DEVICE_TYPE "esp32-c3-bedlift"
-#define FIRMWARE_VERSION "1.1.0-bedlift"
-#define DEFAULT_MQTT_PORT 1883
-
-// GPIO Pins - Relays
-#define RELAY_UP_PIN 2     // GPIO2 - Relay 1 (raises bed)
-#define RELAY_DOWN_PIN 3   // GPIO3 - Relay 2 (lowers bed)
-#define LED_PIN 8          // GPIO8 - Onboard LED
-
-// GPIO Pins - HC-SR04 Ultrasonic
-#define ULTRASONIC_TRIG_PIN 4   // GPIO4 - Trigger
-#define ULTRASONIC_ECHO_PIN 5   // GPIO5 - Echo (use voltage divider!)
-
-// GPIO Pins - Reed Switches (limit switches)
-#define REED_TOP_PIN 6     // GPIO6 - Top limit (bed fully raised)
-#define REED_BOTTOM_PIN 7  // GPIO7 - Bottom limit (bed fully lowered)
-
-// Relay active state (most modules are active LOW)
-#define RELAY_ON LOW
-#define RELAY_OFF HIGH
-
-// Default lift duration in milliseconds
-#define DEFAULT_LIFT_DURATION 3000
-
-// Safety thresholds
-#define MIN_SAFE_DISTANCE_CM 10     // Stop if obstacle closer than this
-#define ULTRASONIC_TIMEOUT_US 30000 // 30ms timeout (~5m max range)
-#define ULTRASONIC_READ_INTERVAL 100 // Read sensor every 100ms
-
-// ============== Global Objects ==============
-
-espMqttClient mqttClient;
-AsyncWebServer webServer(80);
-Preferences preferences;
-WiFiManager wifiManager;
-
-// Timers
-unsigned long lastHealthPublish = 0;
-unsigned long lastStatePublish = 0;
-unsigned long lastReconnectAttempt = 0;
-unsigned long lastUltrasonicRead = 0;
-
-// ============== Device State ==============
-
-struct DeviceConfig {
-    char deviceName[32];
-    char mqttServer[64];
-    int mqttPort;
-    char mqttUser[32];
-    char mqttPass[32];
-    char topicPrefix[32];
-    unsigned long liftDuration;  // milliseconds
-} config;
-
-struct DeviceState {
-    bool mqttConnected = false;
-    unsigned long uptime = 0;
-    int rssi = 0;
-    // Bed lift state
-    bool isLifting = false;
-    String liftDirection = "";  // "raise" or "lower"
-    unsigned long liftStartTime = 0;
-    bool relayUp = false;
-    bool relayDown = false;
-    // Safety sensors
-    float distanceCm = 0;           // Current ultrasonic reading
-    bool ultrasonicOk = false;      // Sensor connected and reading valid
-    bool atTopLimit = false;        // Reed switch: at top
-    bool atBottomLimit = false;     // Reed switch: at bottom
-    String lastStopReason = "";     // Why we stopped (timer/limit/obstacle/manual)
-    // Calibration data
-    float calibratedTopCm = 0;      // Distance reading at top
-    float calibratedBottomCm = 0;   // Distance reading at bottom
-    int positionPercent = -1;       // -1 = uncalibrated, 0-100 = position
-} state;
-
-String deviceId;
-String discoveryTopic;
-String stateTopic;
-String commandTopic;
-String availabilityTopic;
-String healthTopic;
-String logsTopic;
-
-// Log buffer for MQTT publishing
-#define LOG_BUFFER_SIZE 20
-#define LOG_MSG_SIZE 128
-char logBuffer[LOG_BUFFER_SIZE][LOG_MSG_SIZE];
-int logBufferHead = 0;
-int logBufferCount = 0;
-unsigned long lastLogPublish = 0;
-#define LOG_PUBLISH_INTERVAL 500
-
-// Debug tracking
-int reconnectCount = 0;
-String lastError = "none";
-unsigned long lastConnectTime = 0;
-String currentClientId;
-
-// ============== Forward Declarations ==============
-
-void setupMQTT();
-void connectMQTT();
-void publishDiscovery();
-void publishState();
-void publishHealth();
-void publishLog(const char* msg);
-void publishBufferedLogs();
-void mqttLog(const char* format, ...);
-void loadConfig();
-void saveConfig();
-String getDeviceId();
-void setupWebServer();
-void startLift(const String& direction);
-void stopLift();
-void stopLift(const String& reason);
-void updateLift();
-// Safety sensors
-void setupSensors();
-float readUltrasonic();
-void readReedSwitches();
-void updateSensors();
-bool isSafeToMove(const String& direction);
-void calibratePosition(const String& position);
-int calculatePositionPercent();
-
-// ============== MQTT Callbacks ==============
-
-void onMqttConnect(bool sessionPresent) {
-    mqttLog("[MQTT] Connected! Session present: %d\n", sessionPresent);
-    state.mqttConnected = true;
-    lastConnectTime = millis();
-    lastError = "none";
-
-    // Subscribe to command topic
-    uint16_t packetId = mqttClient.subscribe(commandTopic.c_str(), 1);
-    Serial.printf("[MQTT] Subscribed to %s (packet %d)\n", commandTopic.c_str(), packetId);
-
-    // Publish online status
-    mqttClient.publish(availabilityTopic.c_str(), 1, true, "online");
-
-    // Publish discovery and initial state
-    publishDiscovery();
-    publishState();
-    publishHealth();
-
-    // Blink LED to indicate connection
-    for (int i = 0; i < 3; i++) {
-        digitalWrite(LED_PIN, LOW);
-        delay(100);
-        digitalWrite(LED_PIN, HIGH);
-        delay(100);
-    }
-}
-
-void onMqttDisconnect(espMqttClientTypes::DisconnectReason reason) {
-    mqttLog("[MQTT] Disconnected! Reason: %d\n", (int)reason);
-    state.mqttConnected = false;
-
-    switch (reason) {
-        case espMqttClientTypes::DisconnectReason::TCP_DISCONNECTED:
-            lastError = "TCP_DISCONNECTED";
-            break;
-        case espMqttClientTypes::DisconnectReason::MQTT_SERVER_UNAVAILABLE:
-            lastError = "SERVER_UNAVAILABLE";
-            break;
-        default:
-            lastError = "UNKNOWN";
-    }
-}
-
-void onMqttMessage(const espMqttClientTypes::MessageProperties& properties,
-                   const char* topic, const uint8_t* payload, size_t len,
-                   size_t index, size_t total) {
-    Serial.printf("[MQTT] Message on %s (%d bytes)\n", topic, len);
-
-    // Parse JSON payload
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, payload, len);
-
-    if (error) {
-        Serial.printf("[MQTT] JSON parse error: %s\n", error.c_str());
-        return;
-    }
-
-    // Handle control commands
-    if (doc["capability"].is<JsonObject>()) {
-        JsonObject capability = doc["capability"];
-        const char* instance = capability["instance"];
-
-        if (instance && strcmp(instance, "bedLift") == 0) {
-            const char* value = capability["value"];
-
-            if (strcmp(value, "raise") == 0) {
-                mqttLog("[CMD] RAISE - Starting bed lift UP\n");
-                startLift("raise");
-            }
-            else if (strcmp(value, "lower") == 0) {
-                mqttLog("[CMD] LOWER - Starting bed lift DOWN\n");
-                startLift("lower");
-            }
-            else if (strcmp(value, "stop") == 0) {
-                mqttLog("[CMD] STOP - Stopping bed lift\n");
-                stopLift("manual");
-            }
-            else if (strcmp(value, "calibrate_top") == 0) {
-                Serial.println("[CMD] CALIBRATE TOP - Setting current position as top");
-                calibratePosition("top");
-            }
-            else if (strcmp(value, "calibrate_bottom") == 0) {
-                Serial.println("[CMD] CALIBRATE BOTTOM - Setting current position as bottom");
-                calibratePosition("bottom");
-            }
-        }
-    }
-}
-
-// ============== Bed Lift Control ==============
-
-void startLift(const String& direction) {
-    // Safety check before moving
-    if (!isSafeToMove(direction)) {
-        mqttLog("[LIFT] BLOCKED - Not safe to move %s\n", direction.c_str());
-        return;
-    }
-
-    // Safety: stop any current operation first
-    stopLift("starting_new");
-
-    state.liftDirection = direction;
-    state.liftStartTime = millis();
-    state.isLifting = true;
-    state.lastStopReason = "";
-
-    if (direction == "raise") {
-        digitalWrite(RELAY_UP_PIN, RELAY_ON);
-        digitalWrite(RELAY_DOWN_PIN, RELAY_OFF);
-        state.relayUp = true;
-        state.relayDown = false;
-        Serial.println("[LIFT] Relay UP activated");
-    }
-    else if (direction == "lower") {
-        digitalWrite(RELAY_UP_PIN, RELAY_OFF);
-        digitalWrite(RELAY_DOWN_PIN, RELAY_ON);
-        state.relayUp = false;
-        state.relayDown = true;
-        Serial.println("[LIFT] Relay DOWN activated");
-    }
-
-    // LED on while lifting
-    digitalWrite(LED_PIN, LOW);
-
-    publishState();
-}
-
-void stopLift() {
-    stopLift("manual");
-}
-
-void stopLift(const String& reason) {
-    digitalWrite(RELAY_UP_PIN, RELAY_OFF);
-    digitalWrite(RELAY_DOWN_PIN, RELAY_OFF);
-
-    if (state.isLifting) {
-        unsigned long duration = millis() - state.liftStartTime;
-        mqttLog("[LIFT] Stopped after %lu ms (reason: %s)\n", duration, reason.c_str());
-        state.lastStopReason = reason;
-    }
-
-    state.isLifting = false;
-    state.liftDirection = "";
-    state.liftStartTime = 0;
-    state.relayUp = false;
-    state.relayDown = false;
-
-    // LED off when stopped
-    digitalWrite(LED_PIN, HIGH);
-
-    publishState();
-}
-
-void updateLift() {
-    if (!state.isLifting) return;
-
-    // Check if timer has expired
-    if (millis() - state.liftStartTime >= config.liftDuration) {
-        Serial.printf("[LIFT] Timer expired (%lu ms)\n", config.liftDuration);
-        stopLift("timer");
-        return;
-    }
-
-    // Safety: Check limit switches
-    if (state.liftDirection == "raise" && state.atTopLimit) {
-        mqttLog("[SAFETY] Top limit reached!\n");
-        stopLift("top_limit");
-        return;
-    }
-    if (state.liftDirection == "lower" && state.atBottomLimit) {
-        mqttLog("[SAFETY] Bottom limit reached!\n");
-        stopLift("bottom_limit");
-        return;
-    }
-
-    // Safety: Check ultrasonic distance when lowering
-    if (state.liftDirection == "lower" && state.ultrasonicOk) {
-        if (state.distanceCm > 0 && state.distanceCm < MIN_SAFE_DISTANCE_CM) {
-            mqttLog("[SAFETY] Obstacle detected! Distance: %.1f cm\n", state.distanceCm);
-            stopLift("obstacle");
-            return;
-        }
-    }
-}
-
-// ============== Safety Sensors ==============
-
-void setupSensors() {
-    // Ultrasonic HC-SR04
-    pinMode(ULTRASONIC_TRIG_PIN, OUTPUT);
-    pinMode(ULTRASONIC_ECHO_PIN, INPUT);
-    digitalWrite(ULTRASONIC_TRIG_PIN, LOW);
-
-    // Reed switches (with internal pullup - LOW when magnet present)
-    pinMode(REED_TOP_PIN, INPUT_PULLUP);
-    pinMode(REED_BOTTOM_PIN, INPUT_PULLUP);
-
-    Serial.println("[SENSORS] Initialized: Ultrasonic + Reed switches");
-
-    // Initial read
-    updateSensors();
-}
-
-float readUltrasonic() {
-    // Send trigger pulse
-    digitalWrite(ULTRASONIC_TRIG_PIN, LOW);
-    delayMicroseconds(2);
-    digitalWrite(ULTRASONIC_TRIG_PIN, HIGH);
-    delayMicroseconds(10);
-    digitalWrite(ULTRASONIC_TRIG_PIN, LOW);
-
-    // Measure echo pulse duration
-    unsigned long duration = pulseIn(ULTRASONIC_ECHO_PIN, HIGH, ULTRASONIC_TIMEOUT_US);
-
-    if (duration == 0) {
-        // Timeout - no echo received
-        return -1;
-    }
-
-    // Calculate distance: speed of sound = 343 m/s = 0.0343 cm/us
-    // Distance = (duration * 0.0343) / 2
-    float distance = (duration * 0.0343) / 2.0;
-
-    return distance;
-}
-
-void readReedSwitches() {
-    // Reed switches are active LOW (connected to ground when magnet present)
-    bool topTriggered = (digitalRead(REED_TOP_PIN) == LOW);
-    bool bottomTriggered = (digitalRead(REED_BOTTOM_PIN) == LOW);
-
-    // Detect changes
-    if (topTriggered != state.atTopLimit) {
-        state.atTopLimit = topTriggered;
-        Serial.printf("[REED] Top limit: %s\n", topTriggered ? "TRIGGERED" : "clear");
-    }
-    if (bottomTriggered != state.atBottomLimit) {
-        state.atBottomLimit = bottomTriggered;
-        Serial.printf("[REED] Bottom limit: %s\n", bottomTriggered ? "TRIGGERED" : "clear");
-    }
-}
-
-void updateSensors() {
-    // Read ultrasonic at intervals (avoid blocking too often)
-    if (millis() - lastUltrasonicRead >= ULTRASONIC_READ_INTERVAL) {
-        lastUltrasonicRead = millis();
-
-        float distance = readUltrasonic();
-        if (distance > 0) {
-            state.distanceCm = distance;
-            state.ultrasonicOk = true;
-        } else {
-            state.ultrasonicOk = false;
-        }
-
-        // Update position percentage if calibrated
-        state.positionPercent = calculatePositionPercent();
-    }
-
-    // Reed switches can be read every loop (they're fast)
-    readReedSwitches();
-}
-
-bool isSafeToMove(const String& direction) {
-    // Check limit switches
-    if (direction == "raise" && state.atTopLimit) {
-        Serial.println("[SAFETY] Already at top limit");
-        return false;
-    }
-    if (direction == "lower" && state.atBottomLimit) {
-        Serial.println("[SAFETY] Already at bottom limit");
-        return false;
-    }
-
-    // Check ultrasonic when lowering
-    if (direction == "lower" && state.ultrasonicOk) {
-        if (state.distanceCm > 0 && state.distanceCm < MIN_SAFE_DISTANCE_CM) {
-            Serial.printf("[SAFETY] Obstacle below! Distance: %.1f cm\n", state.distanceCm);
-            return false;
-        }
-    }
-
-    return true;
-}
-
-void calibratePosition(const String& position) {
-    if (!state.ultrasonicOk) {
-        Serial.println("[CALIBRATE] Error: Ultrasonic sensor not reading");
-        return;
-    }
-
-    if (position == "top") {
-        state.calibratedTopCm = state.distanceCm;
-        Serial.printf("[CALIBRATE] Top position set to %.1f cm\n", state.calibratedTopCm);
-    } else if (position == "bottom") {
-        state.calibratedBottomCm = state.distanceCm;
-        Serial.printf("[CALIBRATE] Bottom position set to %.1f cm\n", state.calibratedBottomCm);
-    }
-
-    // Recalculate position
-    state.positionPercent = calculatePositionPercent();
-    publishState();
-}
-
-int calculatePositionPercent() {
-    // Need both calibration points
-    if (state.calibratedTopCm == 0 || state.calibratedBottomCm == 0) {
-        return -1;  // Not calibrated
-    }
-    if (!state.ultrasonicOk) {
-        return -1;  // No valid reading
-    }
-
-    // Calculate percentage (0% = bottom, 100% = top)
-    float range = state.calibratedBottomCm - state.calibratedTopCm;
-    if (range <= 0) {
-        return -1;  // Invalid calibration
-    }
-
-    float fromBottom = state.calibratedBottomCm - state.distanceCm;
-    int percent = (int)((fromBottom / range) * 100);
-
-    // Clamp to 0-100
-    if (percent < 0) percent = 0;
-    if (percent > 100) percent = 100;
-
-    return percent;
-}
-
-// ============== Setup ==============
-
-void setup() {
-    Serial.begin(115200);
-    delay(500);
-
-    Serial.println("\n\n=== BedLiftBee ===");
-    Serial.println("Happy Jack Bed Lift Controller");
-    Serial.printf("Firmware: %s\n", FIRMWARE_VERSION);
-
-    // Initialize GPIO
-    pinMode(RELAY_UP_PIN, OUTPUT);
-    pinMode(RELAY_DOWN_PIN, OUTPUT);
-    pinMode(LED_PIN, OUTPUT);
-
-    // Ensure relays are OFF at startup
-    digitalWrite(RELAY_UP_PIN, RELAY_OFF);
-    digitalWrite(RELAY_DOWN_PIN, RELAY_OFF);
-    digitalWrite(LED_PIN, HIGH);  // LED off (active-low)
-
-    Serial.println("[RELAYS] Initialized - both OFF");
-
-    // Setup safety sensors
-    setupSensors();
-
-    // Generate device ID
-    deviceId = getDeviceId();
-    Serial.printf("Device ID: %s\n", deviceId.c_str());
-
-    // Load configuration
-    loadConfig();
-
-    // Setup WiFi Manager
-    WiFiManagerParameter mqttServerParam("mqtt_server", "MQTT Server", config.mqttServer, 64);
-    WiFiManagerParameter mqttPortParam("mqtt_port", "MQTT Port", String(config.mqttPort).c_str(), 6);
-    WiFiManagerParameter deviceNameParam("device_name", "Device Name", config.deviceName, 32);
-    WiFiManagerParameter liftDurationParam("lift_duration", "Lift Duration (ms)", String(config.liftDuration).c_str(), 8);
-
-    wifiManager.addParameter(&mqttServerParam);
-    wifiManager.addParameter(&mqttPortParam);
-    wifiManager.addParameter(&deviceNameParam);
-    wifiManager.addParameter(&liftDurationParam);
-
-    String apName = "BedLiftBee-Setup-" + deviceId.substring(deviceId.length() - 4);
-    wifiManager.setConfigPortalTimeout(180);
-
-    Serial.println("Starting WiFi Manager...");
-    if (!wifiManager.autoConnect(apName.c_str())) {
-        Serial.println("Failed to connect, restarting...");
-        delay(3000);
-        ESP.restart();
-    }
-
-    // Save any updated parameters
-    strcpy(config.mqttServer, mqttServerParam.getValue());
-    config.mqttPort = atoi(mqttPortParam.getValue());
-    strcpy(config.deviceName, deviceNameParam.getValue());
-    config.liftDuration = atoi(liftDurationParam.getValue());
-    if (config.liftDuration < 500) config.liftDuration = DEFAULT_LIFT_DURATION;
-    saveConfig();
-
-    Serial.printf("WiFi connected! IP: %s\n", WiFi.localIP().toString().c_str());
-
-    // Setup mDNS
-    String mdnsName = "bedliftbee-" + deviceId.substring(deviceId.length() - 6);
-    if (MDNS.begin(mdnsName.c_str())) {
-        Serial.printf("mDNS: http://%s.local\n", mdnsName.c_str());
-        MDNS.addService("http", "tcp", 80);
-    }
-
-    // Build MQTT topics
-    String prefix = String(config.topicPrefix);
-    discoveryTopic = prefix + "/discovery/" + deviceId + "/config";
-    stateTopic = prefix + "/devices/" + deviceId + "/state";
-    commandTopic = prefix + "/devices/" + deviceId + "/set";
-    availabilityTopic = prefix + "/devices/" + deviceId + "/availability";
-    healthTopic = prefix + "/devices/" + deviceId + "/health";
-    logsTopic = prefix + "/devices/" + deviceId + "/logs";
-
-    // Setup MQTT
-    setupMQTT();
-
-    // Setup Web Server
-    setupWebServer();
-
-    Serial.println("Setup complete!\n");
-}
-
-// ============== Main Loop ==============
-
-void loop() {
-    // Update state
-    state.uptime = millis() / 1000;
-    state.rssi = WiFi.RSSI();
-
-    // Update safety sensors
-    updateSensors();
-
-    // Update bed lift timer (includes safety checks)
-    updateLift();
-
-    // Reconnect MQTT if needed
-    if (!state.mqttConnected && WiFi.isConnected()) {
-        if (millis() - lastReconnectAttempt > 5000) {
-            lastReconnectAttempt = millis();
-            connectMQTT();
-        }
-    }
-
-    // Publish health every 5 seconds
-    if (state.mqttConnected && millis() - lastHealthPublish > 5000) {
-        lastHealthPublish = millis();
-        publishHealth();
-    }
-
-    // Publish state every 30 seconds
-    if (state.mqttConnected && millis() - lastStatePublish > 30000) {
-        lastStatePublish = millis();
-        publishState();
-    }
-
-    // Publish buffered logs
-    publishBufferedLogs();
-
-    delay(10);
-}
-
-// ============== MQTT Functions ==============
-
-void setupMQTT() {
-    mqttClient.onConnect(onMqttConnect);
-    mqttClient.onDisconnect(onMqttDisconnect);
-    mqttClient.onMessage(onMqttMessage);
-
-    mqttClient.setServer(config.mqttServer, config.mqttPort);
-
-    if (strlen(config.mqttUser) > 0) {
-        mqttClient.setCredentials(config.mqttUser, config.mqttPass);
-    }
-
-    mqttClient.setKeepAlive(60);
-    mqttClient.setWill(availabilityTopic.c_str(), 1, true, "offline");
-
-    Serial.printf("[MQTT] Configured for %s:%d\n", config.mqttServer, config.mqttPort);
-}
-
-void connectMQTT() {
-    reconnectCount++;
-    currentClientId = "bedliftbee-" + deviceId + "-" + String(millis());
-
-    Serial.printf("[MQTT] Connecting... (attempt #%d)\n", reconnectCount);
-    mqttClient.setClientId(currentClientId.c_str());
-    mqttClient.connect();
-}
-
-void publishDiscovery() {
-    JsonDocument doc;
-
-    doc["device_id"] = deviceId;
-    doc["name"] = config.deviceName;
-    doc["type"] = DEVICE_TYPE;
-    doc["model"] = "ESP32-C3 BedLiftBee";
-    doc["firmware_version"] = FIRMWARE_VERSION;
-    doc["ip_address"] = WiFi.localIP().toString();
-
-    JsonArray capabilities = doc["capabilities"].to<JsonArray>();
-
-    // Bed lift capability
-    JsonObject liftCap = capabilities.add<JsonObject>();
-    liftCap["type"] = "devices.capabilities.mode";
-    liftCap["instance"] = "bedLift";
-    JsonObject params = liftCap["parameters"].to<JsonObject>();
-    params["dataType"] = "ENUM";
-    JsonArray options = params["options"].to<JsonArray>();
-
-    JsonObject opt1 = options.add<JsonObject>();
-    opt1["name"] = "Raise";
-    opt1["value"] = "raise";
-
-    JsonObject opt2 = options.add<JsonObject>();
-    opt2["name"] = "Lower";
-    opt2["value"] = "lower";
-
-    JsonObject opt3 = options.add<JsonObject>();
-    opt3["name"] = "Stop";
-    opt3["value"] = "stop";
-
-    doc["sensors"] = JsonArray();
-    doc["timestamp"] = state.uptime;
-
-    String payload;
-    serializeJson(doc, payload);
-
-    mqttClient.publish(discoveryTopic.c_str(), 1, true, payload.c_str());
-    Serial.printf("[MQTT] Published discovery (%d bytes)\n", payload.length());
-}
-
-void publishState() {
-    JsonDocument doc;
-
-    doc["isLifting"] = state.isLifting;
-    doc["direction"] = state.liftDirection;
-    doc["relayUp"] = state.relayUp;
-    doc["relayDown"] = state.relayDown;
-    doc["liftDuration"] = config.liftDuration;
-    doc["rssi"] = state.rssi;
-    doc["uptime"] = state.uptime;
-    doc["ip"] = WiFi.localIP().toString();
-    doc["timestamp"] = state.uptime;
-
-    // Safety sensor data
-    doc["distanceCm"] = state.distanceCm;
-    doc["ultrasonicOk"] = state.ultrasonicOk;
-    doc["atTopLimit"] = state.atTopLimit;
-    doc["atBottomLimit"] = state.atBottomLimit;
-    doc["positionPercent"] = state.positionPercent;
-    doc["lastStopReason"] = state.lastStopReason;
-
-    if (state.isLifting) {
-        unsigned long remaining = config.liftDuration - (millis() - state.liftStartTime);
-        doc["liftTimeRemaining"] = remaining;
-    }
-
-    String payload;
-    serializeJson(doc, payload);
-
-    mqttClient.publish(stateTopic.c_str(), 1, true, payload.c_str());
-}
-
-void publishHealth() {
-    JsonDocument doc;
-
-    doc["uptime"] = state.uptime;
-    doc["wifi_rssi"] = state.rssi;
-    doc["wifi_connected"] = WiFi.isConnected();
-    doc["mqtt_connected"] = state.mqttConnected;
-    doc["mqtt_state"] = state.mqttConnected ? "connected" : "disconnected";
-    doc["free_heap"] = ESP.getFreeHeap();
-    doc["ip"] = WiFi.localIP().toString();
-    doc["reconnect_count"] = reconnectCount;
-    doc["last_error"] = lastError;
-    doc["isLifting"] = state.isLifting;
-    doc["direction"] = state.liftDirection;
-    doc["timestamp"] = millis();
-    doc["client_id"] = currentClientId;
-    doc["firmware"] = FIRMWARE_VERSION;
-
-    // Safety sensor data
-    doc["distanceCm"] = state.distanceCm;
-    doc["ultrasonicOk"] = state.ultrasonicOk;
-    doc["atTopLimit"] = state.atTopLimit;
-    doc["atBottomLimit"] = state.atBottomLimit;
-    doc["positionPercent"] = state.positionPercent;
-
-    String payload;
-    serializeJson(doc, payload);
-
-    mqttClient.publish(healthTopic.c_str(), 0, false, payload.c_str());
-}
-
-// ============== MQTT Logging ==============
-
-void publishLog(const char* msg) {
-    if (!mqttClient.connected()) return;
-
-    JsonDocument doc;
-    doc["ts"] = state.uptime;
-    doc["msg"] = msg;
-
-    String payload;
-    serializeJson(doc, payload);
-    mqttClient.publish(logsTopic.c_str(), 0, false, payload.c_str());
-}
-
-void publishBufferedLogs() {
-    if (!mqttClient.connected() || logBufferCount == 0) return;
-    if (millis() - lastLogPublish < LOG_PUBLISH_INTERVAL) return;
-
-    // Publish oldest log from buffer
-    int index = (logBufferHead - logBufferCount + LOG_BUFFER_SIZE) % LOG_BUFFER_SIZE;
-    publishLog(logBuffer[index]);
-    logBufferCount--;
-    lastLogPublish = millis();
-}
-
-void mqttLog(const char* format, ...) {
-    char buffer[LOG_MSG_SIZE];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    va_end(args);
-
-    // Always print to Serial
-    Serial.print(buffer);
-
-    // Add to MQTT buffer (circular buffer)
-    strncpy(logBuffer[logBufferHead], buffer, LOG_MSG_SIZE - 1);
-    logBuffer[logBufferHead][LOG_MSG_SIZE - 1] = '\0';
-    logBufferHead = (logBufferHead + 1) % LOG_BUFFER_SIZE;
-    if (logBufferCount < LOG_BUFFER_SIZE) {
-        logBufferCount++;
-    }
-}
-
-// ============== Async Web Server ==============
-
-void setupWebServer() {
-    // Root page - device status
-    webServer.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
-        String html = R"rawhtml(
-<!DOCTYPE html>
-<html>
-<head>
-    <meta name="viewport" content="width=device-width, initial-scale=1">
-    <title>BedLiftBee</title>
-    <style>
-        body { font-family: -apple-system, sans-serif; background: #1a1a1a; color: #fff; margin: 0; padding: 20px; }
-        .container { max-width: 400px; margin: 0 auto; }
-        h1 { color: #f97316; margin-bottom: 5px; }
-        .subtitle { color: #666; margin-bottom: 20px; }
-        .card { background: #2a2a2a; border-radius: 12px; padding: 20px; margin-bottom: 15px; }
-        .status-row { display: flex; justify-content: space-between; padding: 8px 0; border-bottom: 1px solid #333; }
-        .status-row:last-child { border: none; }
-        .label { color: #888; }
-        .value { color: #fff; font-weight: 500; }
-        .online { color: #22c55e; }
-        .offline { color: #ef4444; }
-        .btn { display: block; width: 100%; padding: 15px; border: none; border-radius: 8px; font-size: 16px; cursor: pointer; margin-top: 10px; box-sizing: border-box; }
-        .btn-raise { background: #22c55e; color: white; }
-        .btn-lower { background: #3b82f6; color: white; }
-        .btn-stop { background: #ef4444; color: white; }
-        .btn-secondary { background: #333; color: #fff; text-align: center; text-decoration: none; }
-        .btn-grid { display: grid; grid-template-columns: 1fr 1fr; gap: 10px; }
-        .btn-full { grid-column: span 2; }
-        .lifting { background: #f97316; animation: pulse 1s infinite; }
-        @keyframes pulse { 0%, 100% { opacity: 1; } 50% { opacity: 0.6; } }
-        .badge { background: #f97316; color: white; padding: 2px 8px; border-radius: 4px; font-size: 12px; margin-left: 8px; }
-    </style>
-</head>
-<body>
-    <div class="container">
-        <h1>)rawhtml";
-        html += config.deviceName;
-        html += R"rawhtml(<span class="badge">BED</span></h1>
-        <p class="subtitle">Happy Jack Bed Lift Controller</p>
-        <div class="card">
-            <div class="status-row">
-                <span class="label">Status</span>
-                <span class="value )rawhtml";
-        html += state.isLifting ? "lifting" : "";
-        html += R"rawhtml(">)rawhtml";
-        html += state.isLifting ? ("LIFTING " + state.liftDirection) : "IDLE";
-        html += R"rawhtml(</span>
-            </div>
-            <div class="status-row">
-                <span class="label">Lift Duration</span>
-                <span class="value">)rawhtml";
-        html += String(config.liftDuration / 1000.0, 1) + " sec";
-        html += R"rawhtml(</span>
-            </div>
-            <div class="status-row">
-                <span class="label">WiFi Signal</span>
-                <span class="value">)rawhtml";
-        html += String(state.rssi) + " dBm";
-        html += R"rawhtml(</span>
-            </div>
-            <div class="status-row">
-                <span class="label">MQTT Status</span>
-                <span class="value )rawhtml";
-        html += state.mqttConnected ? "online" : "offline";
-        html += R"rawhtml(">)rawhtml";
-        html += state.mqttConnected ? "Connected" : "Disconnected";
-        html += R"rawhtml(</span>
-            </div>
-            <div class="status-row">
-                <span class="label">Uptime</span>
-                <span class="value">)rawhtml";
-        html += String(state.uptime / 3600) + "h " + String((state.uptime % 3600) / 60) + "m";
-        html += R"rawhtml(</span>
-            </div>
-        </div>
-
-        <div class="card">
-            <h3 style="margin-top:0;color:#f97316;">Bed Control</h3>
-            <div class="btn-grid">
-                <button class="btn btn-raise" onclick="fetch('/lift?dir=raise').then(()=>location.reload())">RAISE</button>
-                <button class="btn btn-lower" onclick="fetch('/lift?dir=lower').then(()=>location.reload())">LOWER</button>
-                <button class="btn btn-stop btn-full" onclick="fetch('/lift?dir=stop').then(()=>location.reload())">STOP</button>
-            </div>
-        </div>
-
-        <a href="/config" class="btn btn-secondary">Settings</a>
-    </div>
-    <script>setTimeout(()=>location.reload(), 2000);</script>
-</body>
-</html>)rawhtml";
-
-        request->send(200, "text/html", html);
-    });
-
-    // Config page
-    webServer.on("/config", HTTP_GET, [](AsyncWebServerRequest *request) {
-        String html = R"rawhtml(
-<!DOCTYPE html>
-<html>
-<head>
-    <meta name="viewport" content="width=device-width, initial-scale=1">
-    <title>Settings - BedLiftBee</title>
-    <style>
-        body { font-family: -apple-system, sans-serif; background: #1a1a1a; color: #fff; margin: 0; padding: 20px; }
-        .container { max-width: 400px; margin: 0 auto; }
-        h1 { color: #f97316; }
-        .card { background: #2a2a2a; border-radius: 12px; padding: 20px; margin-bottom: 15px; }
-        label { display: block; color: #888; margin-bottom: 5px; margin-top: 15px; }
-        input { width: 100%; padding: 12px; border: 1px solid #444; border-radius: 8px; background: #1a1a1a; color: #fff; box-sizing: border-box; }
-        .btn { display: block; width: 100%; padding: 15px; border: none; border-radius: 8px; font-size: 16px; cursor: pointer; margin-top: 15px; box-sizing: border-box; }
-        .btn-primary { background: #f97316; color: white; }
-        .btn-secondary { background: #333; color: #fff; text-align: center; text-decoration: none; }
-        .btn-danger { background: #dc2626; color: white; }
-    </style>
-</head>
-<body>
-    <div class="container">
-        <h1>Settings</h1>
-        <form method="POST" action="/config">
-            <div class="card">
-                <h3 style="margin-top:0;color:#888;">Device</h3>
-                <label>Device Name</label>
-                <input type="text" name="device_name" value=")rawhtml";
-        html += config.deviceName;
-        html += R"rawhtml(">
-                <label>Lift Duration (milliseconds)</label>
-                <input type="number" name="lift_duration" value=")rawhtml";
-        html += String(config.liftDuration);
-        html += R"rawhtml(">
-            </div>
-            <div class="card">
-                <h3 style="margin-top:0;color:#888;">MQTT</h3>
-                <label>Server Address</label>
-                <input type="text" name="mqtt_server" value=")rawhtml";
-        html += config.mqttServer;
-        html += R"rawhtml(">
-                <label>Port</label>
-                <input type="number" name="mqtt_port" value=")rawhtml";
-        html += String(config.mqttPort);
-        html += R"rawhtml(">
-            </div>
-            <button type="submit" class="btn btn-primary">Save Settings</button>
-        </form>
-        <a href="/" class="btn btn-secondary">Back</a>
-        <button class="btn btn-danger" onclick="if(confirm('Reset WiFi settings?')){fetch('/reboot?reset=1').then(()=>alert('Rebooting...'))}">Reset WiFi & Reboot</button>
-    </div>
-</body>
-</html>)rawhtml";
-
-        request->send(200, "text/html", html);
-    });
-
-    // Config save (POST)
-    webServer.on("/config", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (request->hasParam("device_name", true)) {
-            strncpy(config.deviceName, request->getParam("device_name", true)->value().c_str(), sizeof(config.deviceName) - 1);
-        }
-        if (request->hasParam("mqtt_server", true)) {
-            strncpy(config.mqttServer, request->getParam("mqtt_server", true)->value().c_str(), sizeof(config.mqttServer) - 1);
-        }
-        if (request->hasParam("mqtt_port", true)) {
-            config.mqttPort = request->getParam("mqtt_port", true)->value().toInt();
-        }
-        if (request->hasParam("lift_duration", true)) {
-            config.liftDuration = request->getParam("lift_duration", true)->value().toInt();
-            if (config.liftDuration < 500) config.liftDuration = DEFAULT_LIFT_DURATION;
-        }
-
-        saveConfig();
-        request->redirect("/");
-        delay(500);
-        ESP.restart();
-    });
-
-    // Lift control endpoint
-    webServer.on("/lift", HTTP_GET, [](AsyncWebServerRequest *request) {
-        if (request->hasParam("dir")) {
-            String dir = request->getParam("dir")->value();
-            if (dir == "raise") {
-                startLift("raise");
-                request->send(200, "text/plain", "RAISING");
-            } else if (dir == "lower") {
-                startLift("lower");
-                request->send(200, "text/plain", "LOWERING");
-            } else if (dir == "stop") {
-                stopLift();
-                request->send(200, "text/plain", "STOPPED");
-            } else {
-                request->send(400, "text/plain", "Invalid direction");
-            }
-        } else {
-            request->send(400, "text/plain", "Missing dir parameter");
-        }
-    });
-
-    // Reboot
-    webServer.on("/reboot", HTTP_GET, [](AsyncWebServerRequest *request) {
-        if (request->hasParam("reset") && request->getParam("reset")->value() == "1") {
-            wifiManager.resetSettings();
-        }
-        request->send(200, "text/plain", "Rebooting...");
-        delay(500);
-        ESP.restart();
-    });
-
-    // API endpoint
-    webServer.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request) {
-        JsonDocument doc;
-        doc["device_id"] = deviceId;
-        doc["device_name"] = config.deviceName;
-        doc["isLifting"] = state.isLifting;
-        doc["direction"] = state.liftDirection;
-        doc["relayUp"] = state.relayUp;
-        doc["relayDown"] = state.relayDown;
-        doc["liftDuration"] = config.liftDuration;
-        doc["mqtt_connected"] = state.mqttConnected;
-        doc["wifi_rssi"] = state.rssi;
-        doc["uptime"] = state.uptime;
-        doc["free_heap"] = ESP.getFreeHeap();
-        doc["firmware"] = FIRMWARE_VERSION;
-        doc["ip"] = WiFi.localIP().toString();
-        // Safety sensors
-        doc["distanceCm"] = state.distanceCm;
-        doc["ultrasonicOk"] = state.ultrasonicOk;
-        doc["atTopLimit"] = state.atTopLimit;
-        doc["atBottomLimit"] = state.atBottomLimit;
-        doc["positionPercent"] = state.positionPercent;
-        doc["lastStopReason"] = state.lastStopReason;
-        doc["calibratedTopCm"] = state.calibratedTopCm;
-        doc["calibratedBottomCm"] = state.calibratedBottomCm;
-
-        String json;
-        serializeJson(doc, json);
-        request->send(200, "application/json", json);
-    });
-
-    // Calibration endpoint
-    webServer.on("/calibrate", HTTP_GET, [](AsyncWebServerRequest *request) {
-        if (request->hasParam("pos")) {
-            String pos = request->getParam("pos")->value();
-            if (pos == "top" || pos == "bottom") {
-                calibratePosition(pos);
-                request->send(200, "text/plain", "Calibrated " + pos);
-            } else {
-                request->send(400, "text/plain", "Invalid position (use top or bottom)");
-            }
-        } else {
-            request->send(400, "text/plain", "Missing pos parameter");
-        }
-    });
-
-    webServer.begin();
-    Serial.println("[HTTP] Async web server started");
-}
-
-// ============== Configuration Storage ==============
-
-void loadConfig() {
-    preferences.begin("bedliftbee", true);
-
-    preferences.getString("deviceName", config.deviceName, sizeof(config.deviceName));
-    if (strlen(config.deviceName) == 0) {
-        strcpy(config.deviceName, "BedLiftBee");
-    }
-
-    preferences.getString("mqttServer", config.mqttServer, sizeof(config.mqttServer));
-    if (strlen(config.mqttServer) == 0) {
-        strcpy(config.mqttServer, "192.168.0.95");
-    }
-
-    config.mqttPort = preferences.getInt("mqttPort", DEFAULT_MQTT_PORT);
-    config.liftDuration = preferences.getULong("liftDuration", DEFAULT_LIFT_DURATION);
-
-    preferences.getString("mqttUser", config.mqttUser, sizeof(config.mqttUser));
-    preferences.getString("mqttPass", config.mqttPass, sizeof(config.mqttPass));
-
-    preferences.getString("topicPrefix", config.topicPrefix, sizeof(config.topicPrefix));
-    if (strlen(config.topicPrefix) == 0) {
-        strcpy(config.topicPrefix, "homecontrol");
-    }
-
-    preferences.end();
-
-    Serial.printf("[Config] Loaded: name=%s, mqtt=%s:%d, duration=%lu\n",
-                  config.deviceName, config.mqttServer, config.mqttPort, config.liftDuration);
-}
-
-void saveConfig() {
-    preferences.begin("bedliftbee", false);
-    preferences.putString("deviceName", config.deviceName);
-    preferences.putString("mqttServer", config.mqttServer);
-    preferences.putInt("mqttPort", config.mqttPort);
-    preferences.putULong("liftDuration", config.liftDuration);
-    preferences.putString("mqttUser", config.mqttUser);
-    preferences.putString("mqttPass", config.mqttPass);
-    preferences.putString("topicPrefix", config.topicPrefix);
-    preferences.end();
-
-    Serial.println("[Config] Saved");
-}
-
-String getDeviceId() {
-    uint64_t chipid = ESP.getEfuseMac();
-    char id[13];
-    sprintf(id, "%04x%08x", (uint16_t)(chipid >> 32), (uint32_t)chipid);
-    return String(id);
-}
+/**
+ * BedLiftBee - Happy Jack Bed Lift Controller
+ * ESP32-C3 Mini with 2-channel relay module + safety sensors
+ *
+ * Part of the Bee Colony - uses same patterns as TinyBee1/kayciBee1
+ * - WiFiManager for configuration
+ * - ESPAsyncWebServer for status/config
+ * - hive-core for async MQTT, health and config (lib/hive-core)
+ *
+ * Relays simulate pressing the rocker switch:
+ * - Relay 1 (GPIO2): UP - raises the bed
+ * - Relay 2 (GPIO3): DOWN - lowers the bed
+ *
+ * Safety Features:
+ * - HC-SR04 ultrasonic sensor for distance/position tracking
+ * - Reed switches for top/bottom limit detection
+ * - Auto-stop when limits reached or obstacle detected
+ *
+ * MQTT Commands:
+ * - {"capability":{"instance":"bedLift","value":"raise"}}
+ * - {"capability":{"instance":"bedLift","value":"lower"}}
+ * - {"capability":{"instance":"bedLift","value":"stop"}}
+ * - {"capability":{"instance":"bedLift","value":"calibrate"}}
+ * - {"capability":{"instance":"bedPosition","value":40}}  (move to 40%, needs calibration)
+ *
+ * Position comes from an alpha-beta estimator over the ultrasonic
+ * readings. A move to N% drops the relays early by stopLeadMs at the
+ * estimated speed; once the bed coasts to rest the stop error is measured
+ * and stopLeadMs is nudged toward what this bed actually needed. The
+ * top/bottom calibration and stopLeadMs are stored in DeviceConfig, so
+ * move to N% works straight after a reboot.
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiManager.h>
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+#include <Preferences.h>
+#include <ESPmDNS.h>
+#include <HiveCore.h>
+#include <HiveWeb.h>
+#include "web/bedliftbee.h"  // Generated from web/bedliftbee by tools/embed_web.py
+
+// ============== Configuration ==============
+
+#define DEVICE_TYPE "esp32-c3-bedlift"
+#define FIRMWARE_VERSION "1.1.0-bedlift"
+#define CONFIG_VERSION 3          // DeviceConfig layout (HiveConfig.h)
+
+// GPIO Pins - Relays
+#define RELAY_UP_PIN 2     // GPIO2 - Relay 1 (raises bed)
+#define RELAY_DOWN_PIN 3   // GPIO3 - Relay 2 (lowers bed)
+#define LED_PIN 8          // GPIO8 - Onboard LED
+
+// GPIO Pins - HC-SR04 Ultrasonic
+#define ULTRASONIC_TRIG_PIN 4   // GPIO4 - Trigger
+#define ULTRASONIC_ECHO_PIN 5   // GPIO5 - Echo (use voltage divider!)
+
+// GPIO Pins - Reed Switches (limit switches)
+#define REED_TOP_PIN 6     // GPIO6 - Top limit (bed fully raised)
+#define REED_BOTTOM_PIN 7  // GPIO7 - Bottom limit (bed fully lowered)
+
+// Relay active state (most modules are active LOW)
+#define RELAY_ON LOW
+#define RELAY_OFF HIGH
+
+// Default lift duration in milliseconds
+#define DEFAULT_LIFT_DURATION 3000
+
+// Safety thresholds
+#define MIN_SAFE_DISTANCE_CM 10     // Stop if obstacle closer than this
+#define ULTRASONIC_TIMEOUT_US 30000 // 30ms timeout (~5m max range)
+#define ULTRASONIC_READ_INTERVAL 100 // Ping every 100ms when idle
+#define ULTRASONIC_LIFT_INTERVAL 60  // Ping every 60ms while lifting (HC-SR04 minimum)
+#define ULTRASONIC_FILTER_SIZE 5     // Median over the last N good readings
+#define ULTRASONIC_OUTLIER_CM 30     // Reject readings this far from the median...
+#define ULTRASONIC_MAX_REJECTS 3     // ...unless this many in a row (real jump)
+#define ULTRASONIC_MAX_MISSES 3      // Consecutive timeouts before ultrasonicOk = false
+#define OBSTACLE_ECHO_HITS 2         // Consecutive short echoes before the ISR cuts the relays
+
+// Position estimator and move to N%
+#define ESTIMATOR_ALPHA 0.5f         // Position gain per reading
+#define ESTIMATOR_BETA 0.1f          // Velocity gain per reading
+#define ESTIMATOR_MAX_GAP_MS 1000    // Longer without a reading: restart from the next one
+#define MOVE_TIMEOUT_MS 30000        // Safety timer for a move (liftDuration is for presses)
+#define MOVE_DEADBAND_PERCENT 2      // Closer than this to the target: don't move
+#define MOVE_SETTLE_MS 800           // Relays off -> bed at rest (coast is still tracked)
+#define DEFAULT_STOP_LEAD_MS 250     // Relay release + deceleration, learned per bed
+#define MAX_STOP_LEAD_MS 2000
+#define STOP_LEAD_GAIN 0.3f          // How far each move moves stopLeadMs toward the measurement
+#define STOP_LEAD_MIN_SPEED 1.0f     // %/s at the stop; slower moves say nothing about the lead
+#define STOP_LEAD_SAVE_MS 10         // Smaller corrections aren't worth a flash write
+
+// Echo width for MIN_SAFE_DISTANCE_CM (round trip at 0.0343 cm/us)
+#define OBSTACLE_ECHO_US ((uint32_t)(MIN_SAFE_DISTANCE_CM * 2 / 0.0343))
+
+// ============== Global Objects ==============
+
+AsyncWebServer webServer(80);
+Preferences preferences;
+WiFiManager wifiManager;
+
+// Timers
+unsigned long lastUltrasonicRead = 0;
+
+// ============== Hardware Cutoff ==============
+// Reed switches and the obstacle threshold drop the relays straight from
+// their interrupts; loop() only picks up the reason afterwards to log,
+// update state and publish (serviceCutoff()).
+
+enum LiftMotion : uint8_t { MOTION_NONE, MOTION_UP, MOTION_DOWN };
+enum CutoffReason : uint8_t { CUTOFF_NONE, CUTOFF_TOP, CUTOFF_BOTTOM, CUTOFF_OBSTACLE };
+
+portMUX_TYPE liftMux = portMUX_INITIALIZER_UNLOCKED;
+volatile LiftMotion liftMotion = MOTION_NONE;    // What the relays are doing (ISR view)
+volatile CutoffReason cutoffReason = CUTOFF_NONE;
+volatile uint32_t cutoffLatencyUs = 0;           // ISR entry -> both relays off
+volatile uint8_t obstacleHits = 0;
+
+// ============== Ultrasonic Sampler ==============
+// The echo pin is timed by a GPIO interrupt; loop() only fires the 10us
+// trigger and collects the result, so nothing spins on pulseIn().
+
+volatile bool echoArmed = false;      // Set at trigger, cleared by the falling edge
+volatile bool echoReady = false;
+volatile uint32_t echoStartUs = 0;
+volatile uint32_t echoWidthUs = 0;
+
+struct UltrasonicSampler {
+    bool inFlight = false;
+    uint32_t triggerUs = 0;
+    float window[ULTRASONIC_FILTER_SIZE];
+    uint8_t windowCount = 0;
+    uint8_t windowNext = 0;
+    uint8_t rejectRun = 0;
+    uint8_t missRun = 0;
+    // Stats for health
+    uint32_t samples = 0;
+    uint32_t timeouts = 0;
+    uint32_t rejected = 0;
+    uint32_t lastEchoUs = 0;
+    uint32_t readUs = 0;      // Loop time spent in updateUltrasonic() last call
+    uint32_t readMaxUs = 0;
+} ultrasonic;
+
+// ============== Position Estimator ==============
+// Alpha-beta filter over the median-filtered distance. Velocity is only
+// tracked while the relays drive the bed and for MOVE_SETTLE_MS of coast
+// after they drop; at rest it is pinned to zero so noise isn't motion.
+
+struct PositionEstimator {
+    bool valid = false;
+    float positionCm = 0;
+    float velocityCmS = 0;           // + = distance growing
+    uint32_t lastUs = 0;             // Last reading
+    unsigned long relaysOffAt = 0;   // millis() the relays last dropped
+} estimator;
+
+// ============== Device State ==============
+
+struct DeviceConfig : HiveConfig {
+    unsigned long liftDuration;  // milliseconds
+    unsigned long stopLeadMs = DEFAULT_STOP_LEAD_MS;  // Move to N%: relays drop this early (learned)
+    float calibratedTopCm = 0;      // Distance reading at top (0 = not calibrated)
+    float calibratedBottomCm = 0;   // Distance reading at bottom
+} config;
+
+struct DeviceState {
+    // Bed lift state
+    bool isLifting = false;
+    String liftDirection = "";  // "raise" or "lower"
+    unsigned long liftStartTime = 0;
+    bool relayUp = false;
+    bool relayDown = false;
+    // Safety sensors
+    float distanceCm = 0;           // Current ultrasonic reading
+    bool ultrasonicOk = false;      // Sensor connected and reading valid
+    bool atTopLimit = false;        // Reed switch: at top
+    bool atBottomLimit = false;     // Reed switch: at bottom
+    String lastStopReason = "";     // Why we stopped (timer/limit/obstacle/manual)
+    // Position from the calibration in config
+    int positionPercent = -1;       // -1 = uncalibrated, 0-100 = position
+    // Move to N%
+    int targetPercent = -1;         // -1 = no move in progress
+    bool moveSettling = false;      // Stopped for the target, waiting for the bed to come to rest
+    unsigned long moveStoppedAt = 0;
+    int moveTarget = 0;             // Target of the move being settled
+    float moveDirection = 0;        // +1 raise, -1 lower
+    float stopAtPercent = 0;        // Estimate when the relays dropped
+    float stopSpeed = 0;            // %/s when the relays dropped
+    float stopErrorPercent = 0;     // Last move: rest - target, + = overshoot
+    float coastPercent = 0;         // Last move: travel after the relays dropped
+    uint32_t moves = 0;
+    // Hardware cutoff stats
+    uint32_t cutoffCount = 0;
+    uint32_t lastCutoffLatencyUs = 0;
+    uint32_t maxCutoffLatencyUs = 0;
+} state;
+
+const HiveDeviceInfo beeInfo = {DEVICE_TYPE, "ESP32-C3 BedLiftBee", FIRMWARE_VERSION, "bedliftbee"};
+
+// Built once in setup() so lift stops don't allocate topic Strings
+String liftTopic;
+
+// ============== Forward Declarations ==============
+
+void loadConfig();
+void saveConfig();
+void setupWebServer();
+void buildStatus(JsonDocument& doc);
+void startLift(const String& direction);
+void stopLift();
+void stopLift(const String& reason);
+void publishLiftStop(const String& reason, unsigned long duration);
+void updateLift();
+void moveToPercent(int percent);
+// Safety sensors
+void setupSensors();
+void updateUltrasonic();
+void onEchoEdge();
+void onTopLimit();
+void runBenchmarks();  // HIVE_BENCH builds
+void onBottomLimit();
+void serviceCutoff();
+void readReedSwitches();
+void updateSensors();
+bool isSafeToMove(const String& direction);
+void calibratePosition(const String& position);
+int calculatePositionPercent();
+float estimatedPercent();
+float estimatedSpeed();
+
+// ============== Hive Hooks ==============
+
+void onConnect(bool sessionPresent) {
+    // Blink LED to indicate connection
+    for (int i = 0; i < 3; i++) {
+        digitalWrite(LED_PIN, LOW);
+        delay(100);
+        digitalWrite(LED_PIN, HIGH);
+        delay(100);
+    }
+}
+
+void onBedLift(const char* instance, JsonObject capability, JsonDocument& doc) {
+    const char* value = capability["value"];
+    if (!value) return;
+
+    switch (hiveHash(value)) {
+        case hiveHash("raise"):
+            mqttLog("[CMD] RAISE - Starting bed lift UP\n");
+            startLift("raise");
+            break;
+        case hiveHash("lower"):
+            mqttLog("[CMD] LOWER - Starting bed lift DOWN\n");
+            startLift("lower");
+            break;
+        case hiveHash("stop"):
+            mqttLog("[CMD] STOP - Stopping bed lift\n");
+            stopLift("manual");
+            break;
+        case hiveHash("calibrate_top"):
+            Serial.println("[CMD] CALIBRATE TOP - Setting current position as top");
+            calibratePosition("top");
+            break;
+        case hiveHash("calibrate_bottom"):
+            Serial.println("[CMD] CALIBRATE BOTTOM - Setting current position as bottom");
+            calibratePosition("bottom");
+            break;
+    }
+}
+
+void onBedPosition(const char* instance, JsonObject capability, JsonDocument& doc) {
+    if (!capability["value"].is<int>()) return;
+    int percent = capability["value"];
+    mqttLog("[CMD] MOVE TO %d%%\n", percent);
+    moveToPercent(percent);
+}
+
+static const HiveCommand commands[] = {
+    {"bedLift", onBedLift},
+    {"bedPosition", onBedPosition},
+};
+
+void onDiscovery(JsonDocument& doc) {
+    JsonArray capabilities = doc["capabilities"].to<JsonArray>();
+
+    // Bed lift capability
+    JsonObject liftCap = capabilities.add<JsonObject>();
+    liftCap["type"] = "devices.capabilities.mode";
+    liftCap["instance"] = "bedLift";
+    JsonObject params = liftCap["parameters"].to<JsonObject>();
+    params["dataType"] = "ENUM";
+    JsonArray options = params["options"].to<JsonArray>();
+
+    JsonObject opt1 = options.add<JsonObject>();
+    opt1["name"] = "Raise";
+    opt1["value"] = "raise";
+
+    JsonObject opt2 = options.add<JsonObject>();
+    opt2["name"] = "Lower";
+    opt2["value"] = "lower";
+
+    JsonObject opt3 = options.add<JsonObject>();
+    opt3["name"] = "Stop";
+    opt3["value"] = "stop";
+
+    // Move to N% (once calibrated)
+    JsonObject positionCap = capabilities.add<JsonObject>();
+    positionCap["type"] = "devices.capabilities.range";
+    positionCap["instance"] = "bedPosition";
+    JsonObject positionParams = positionCap["parameters"].to<JsonObject>();
+    positionParams["dataType"] = "INTEGER";
+    positionParams["unit"] = "unit.percent";
+    JsonObject range = positionParams["range"].to<JsonObject>();
+    range["min"] = 0;
+    range["max"] = 100;
+    range["precision"] = 1;
+
+    doc["sensors"] = JsonArray();
+}
+
+void onState(JsonDocument& doc) {
+    doc["isLifting"] = state.isLifting;
+    doc["direction"] = state.liftDirection;
+    doc["relayUp"] = state.relayUp;
+    doc["relayDown"] = state.relayDown;
+    doc["liftDuration"] = config.liftDuration;
+
+    // Safety sensor data
+    doc["distanceCm"] = state.distanceCm;
+    doc["ultrasonicOk"] = state.ultrasonicOk;
+    doc["atTopLimit"] = state.atTopLimit;
+    doc["atBottomLimit"] = state.atBottomLimit;
+    doc["positionPercent"] = state.positionPercent;
+    doc["lastStopReason"] = state.lastStopReason;
+
+    // Limit/obstacle cutoff done in ISR (latency = ISR entry -> relays off)
+    doc["cutoffCount"] = state.cutoffCount;
+    doc["cutoffLatencyUs"] = state.lastCutoffLatencyUs;
+    doc["cutoffMaxLatencyUs"] = state.maxCutoffLatencyUs;
+
+    // Estimator and move to N% (tune stopLeadMs per bed from these)
+    doc["positionEstimateCm"] = estimator.positionCm;
+    doc["speedCmS"] = fabsf(estimator.velocityCmS);
+    if (state.positionPercent >= 0) doc["speedPercentPerSec"] = estimatedSpeed();
+    doc["targetPercent"] = state.targetPercent;
+    doc["stopLeadMs"] = config.stopLeadMs;
+    if (state.moves > 0) {
+        doc["stopErrorPercent"] = state.stopErrorPercent;
+        doc["coastPercent"] = state.coastPercent;
+        doc["moves"] = state.moves;
+    }
+
+    if (state.isLifting) {
+        unsigned long limit = state.targetPercent >= 0 ? MOVE_TIMEOUT_MS : config.liftDuration;
+        unsigned long remaining = limit - (millis() - state.liftStartTime);
+        doc["liftTimeRemaining"] = remaining;
+    }
+}
+
+void onHealth(JsonDocument& doc) {
+    doc["isLifting"] = state.isLifting;
+    doc["direction"] = state.liftDirection;
+
+    // Safety sensor data
+    doc["distanceCm"] = state.distanceCm;
+    doc["ultrasonicOk"] = state.ultrasonicOk;
+    doc["atTopLimit"] = state.atTopLimit;
+    doc["atBottomLimit"] = state.atBottomLimit;
+    doc["positionPercent"] = state.positionPercent;
+
+    // Ultrasonic sampler (read time = loop time spent, not echo time)
+    doc["ultrasonic_read_us"] = ultrasonic.readUs;
+    doc["ultrasonic_read_max_us"] = ultrasonic.readMaxUs;
+    doc["ultrasonic_echo_us"] = ultrasonic.lastEchoUs;
+    doc["ultrasonic_interval_ms"] = state.isLifting ? ULTRASONIC_LIFT_INTERVAL : ULTRASONIC_READ_INTERVAL;
+    doc["ultrasonic_samples"] = ultrasonic.samples;
+    doc["ultrasonic_timeouts"] = ultrasonic.timeouts;
+    doc["ultrasonic_rejected"] = ultrasonic.rejected;
+}
+
+// ============== Bed Lift Control ==============
+
+void startLift(const String& direction) {
+    // Safety check before moving
+    if (!isSafeToMove(direction)) {
+        mqttLog("[LIFT] BLOCKED - Not safe to move %s\n", direction.c_str());
+        return;
+    }
+
+    // Safety: stop any current operation first
+    stopLift("starting_new");
+
+    state.liftDirection = direction;
+    state.liftStartTime = millis();
+    state.isLifting = true;
+    state.lastStopReason = "";
+    state.moveSettling = false;  // A new press or move cancels the last measurement
+
+    // Relay + liftMotion change together so a limit ISR can't slip in between
+    if (direction == "raise") {
+        portENTER_CRITICAL(&liftMux);
+        obstacleHits = 0;
+        liftMotion = MOTION_UP;
+        digitalWrite(RELAY_UP_PIN, RELAY_ON);
+        digitalWrite(RELAY_DOWN_PIN, RELAY_OFF);
+        portEXIT_CRITICAL(&liftMux);
+        state.relayUp = true;
+        state.relayDown = false;
+        Serial.println("[LIFT] Relay UP activated");
+    }
+    else if (direction == "lower") {
+        portENTER_CRITICAL(&liftMux);
+        obstacleHits = 0;
+        liftMotion = MOTION_DOWN;
+        digitalWrite(RELAY_UP_PIN, RELAY_OFF);
+        digitalWrite(RELAY_DOWN_PIN, RELAY_ON);
+        portEXIT_CRITICAL(&liftMux);
+        state.relayUp = false;
+        state.relayDown = true;
+        Serial.println("[LIFT] Relay DOWN activated");
+    }
+
+    // LED on while lifting
+    digitalWrite(LED_PIN, LOW);
+
+    hive.publishState();
+    hiveLive.notify();
+}
+
+void stopLift() {
+    stopLift("manual");
+}
+
+void stopLift(const String& reason) {
+    portENTER_CRITICAL(&liftMux);
+    liftMotion = MOTION_NONE;
+    digitalWrite(RELAY_UP_PIN, RELAY_OFF);
+    digitalWrite(RELAY_DOWN_PIN, RELAY_OFF);
+    portEXIT_CRITICAL(&liftMux);
+    estimator.relaysOffAt = millis();
+
+    if (state.isLifting) {
+        unsigned long duration = millis() - state.liftStartTime;
+        mqttLog("[LIFT] Stopped after %lu ms (reason: %s)\n", duration, reason.c_str());
+        state.lastStopReason = reason;
+        publishLiftStop(reason, duration);
+
+        // Only a stop for the target says anything about the stop lead
+        if (state.targetPercent >= 0 && reason == "target") {
+            state.moveSettling = true;
+            state.moveStoppedAt = millis();
+        }
+    }
+
+    state.targetPercent = -1;
+    state.isLifting = false;
+    state.liftDirection = "";
+    state.liftStartTime = 0;
+    state.relayUp = false;
+    state.relayDown = false;
+
+    // LED off when stopped
+    digitalWrite(LED_PIN, HIGH);
+
+    hive.publishState();
+    hiveLive.notify();
+}
+
+// Every stop, not just the last one in retained state; replayed after an outage
+void publishLiftStop(const String& reason, unsigned long duration) {
+    HiveMessage msg;
+    msg.doc["event"] = "stop";
+    msg.doc["reason"] = reason.c_str();
+    msg.doc["direction"] = state.liftDirection.c_str();
+    msg.doc["duration_ms"] = duration;
+    msg.doc["position"] = state.positionPercent;
+    msg.doc["timestamp"] = millis();
+    msg.publishEvent(liftTopic.c_str());
+}
+
+void moveToPercent(int percent) {
+    percent = constrain(percent, 0, 100);
+    if (state.positionPercent < 0) {
+        mqttLog("[LIFT] Move to %d%% needs calibration and a distance reading\n", percent);
+        return;
+    }
+
+    float position = estimatedPercent();
+    if (fabsf(percent - position) < MOVE_DEADBAND_PERCENT) {
+        mqttLog("[LIFT] Already at %.1f%%\n", position);
+        return;
+    }
+
+    startLift(percent > position ? "raise" : "lower");
+    if (!state.isLifting) return;  // Blocked by a limit or obstacle
+
+    state.targetPercent = percent;
+    mqttLog("[LIFT] Moving %s from %.1f%% to %d%% (lead %lu ms)\n", state.liftDirection.c_str(), position,
+            percent, config.stopLeadMs);
+    hive.publishState();
+}
+
+// The bed keeps going for about stopLeadMs after the relays drop, so stop
+// when the target is that far away at the current speed
+static void trackTarget() {
+    if (state.positionPercent < 0) {
+        mqttLog("[LIFT] Lost position during move\n");
+        stopLift("no_position");
+        return;
+    }
+
+    float direction = state.liftDirection == "raise" ? 1.0f : -1.0f;
+    float position = estimatedPercent();
+    float speed = fabsf(estimatedSpeed());
+    float remaining = (state.targetPercent - position) * direction;
+    if (remaining > speed * config.stopLeadMs / 1000.0f) return;
+
+    state.moveTarget = state.targetPercent;
+    state.moveDirection = direction;
+    state.stopAtPercent = position;
+    state.stopSpeed = speed;
+    stopLift("target");
+}
+
+// Once the bed is at rest after a target stop: record the error and move
+// stopLeadMs toward the lead this stop would have needed
+static void finishMove() {
+    if (!state.moveSettling || millis() - state.moveStoppedAt < MOVE_SETTLE_MS) return;
+    state.moveSettling = false;
+    if (state.positionPercent < 0) return;
+
+    float rest = estimatedPercent();
+    state.stopErrorPercent = (rest - state.moveTarget) * state.moveDirection;
+    state.coastPercent = (rest - state.stopAtPercent) * state.moveDirection;
+    state.moves++;
+
+    if (state.stopSpeed >= STOP_LEAD_MIN_SPEED && state.coastPercent > 0) {
+        float measured = state.coastPercent / state.stopSpeed * 1000.0f;
+        float lead = config.stopLeadMs + STOP_LEAD_GAIN * (measured - config.stopLeadMs);
+        unsigned long next = (unsigned long)constrain(lead, 0.0f, (float)MAX_STOP_LEAD_MS);
+        if (labs((long)next - (long)config.stopLeadMs) >= STOP_LEAD_SAVE_MS) {
+            config.stopLeadMs = next;
+            saveConfig();
+        }
+    }
+
+    mqttLog("[LIFT] Move to %d%% came to rest at %.1f%% (error %+.1f%%, coast %.1f%% from %.1f %%/s, lead %lu ms)\n",
+            state.moveTarget, rest, state.stopErrorPercent, state.coastPercent, state.stopSpeed,
+            config.stopLeadMs);
+    hive.publishState();
+    hiveLive.notify();
+}
+
+void updateLift() {
+    HIVE_PERF_SCOPE("updateLift");
+    // Relays may already be off from an ISR - finish the stop here
+    serviceCutoff();
+    finishMove();
+
+    if (!state.isLifting) return;
+
+    // Check if timer has expired (a move gets longer than a press)
+    unsigned long limit = state.targetPercent >= 0 ? MOVE_TIMEOUT_MS : config.liftDuration;
+    if (millis() - state.liftStartTime >= limit) {
+        Serial.printf("[LIFT] Timer expired (%lu ms)\n", limit);
+        stopLift("timer");
+        return;
+    }
+
+    // Safety: Check limit switches
+    if (state.liftDirection == "raise" && state.atTopLimit) {
+        mqttLog("[SAFETY] Top limit reached!\n");
+        stopLift("top_limit");
+        return;
+    }
+    if (state.liftDirection == "lower" && state.atBottomLimit) {
+        mqttLog("[SAFETY] Bottom limit reached!\n");
+        stopLift("bottom_limit");
+        return;
+    }
+
+    // Safety: Check ultrasonic distance when lowering
+    if (state.liftDirection == "lower" && state.ultrasonicOk) {
+        if (state.distanceCm > 0 && state.distanceCm < MIN_SAFE_DISTANCE_CM) {
+            mqttLog("[SAFETY] Obstacle detected! Distance: %.1f cm\n", state.distanceCm);
+            stopLift("obstacle");
+            return;
+        }
+    }
+
+    if (state.targetPercent >= 0) trackTarget();
+}
+
+// ============== Safety Sensors ==============
+
+void setupSensors() {
+    // Ultrasonic HC-SR04
+    pinMode(ULTRASONIC_TRIG_PIN, OUTPUT);
+    pinMode(ULTRASONIC_ECHO_PIN, INPUT);
+    digitalWrite(ULTRASONIC_TRIG_PIN, LOW);
+    attachInterrupt(ULTRASONIC_ECHO_PIN, onEchoEdge, CHANGE);
+
+    // Reed switches (with internal pullup - LOW when magnet present)
+    pinMode(REED_TOP_PIN, INPUT_PULLUP);
+    pinMode(REED_BOTTOM_PIN, INPUT_PULLUP);
+    attachInterrupt(REED_TOP_PIN, onTopLimit, FALLING);
+    attachInterrupt(REED_BOTTOM_PIN, onBottomLimit, FALLING);
+
+    Serial.println("[SENSORS] Initialized: Ultrasonic + Reed switches");
+
+    // Initial read
+    updateSensors();
+}
+
+// Drop both relays from interrupt context; first reason wins until serviced
+void IRAM_ATTR cutRelays(CutoffReason reason, uint32_t triggerUs) {
+    portENTER_CRITICAL_ISR(&liftMux);
+    digitalWrite(RELAY_UP_PIN, RELAY_OFF);
+    digitalWrite(RELAY_DOWN_PIN, RELAY_OFF);
+    liftMotion = MOTION_NONE;
+    if (cutoffReason == CUTOFF_NONE) {
+        cutoffReason = reason;
+        cutoffLatencyUs = micros() - triggerUs;
+    }
+    portEXIT_CRITICAL_ISR(&liftMux);
+}
+
+void IRAM_ATTR onTopLimit() {
+    uint32_t now = micros();
+    if (liftMotion == MOTION_UP) cutRelays(CUTOFF_TOP, now);
+}
+
+void IRAM_ATTR onBottomLimit() {
+    uint32_t now = micros();
+    if (liftMotion == MOTION_DOWN) cutRelays(CUTOFF_BOTTOM, now);
+}
+
+// Times the echo pulse; edges outside an armed ping are stray echoes
+void IRAM_ATTR onEchoEdge() {
+    if (!echoArmed) return;
+
+    uint32_t now = micros();
+    if (digitalRead(ULTRASONIC_ECHO_PIN) == HIGH) {
+        echoStartUs = now;
+    } else if (echoStartUs != 0) {
+        echoWidthUs = now - echoStartUs;
+        echoArmed = false;
+        echoReady = true;
+
+        // Obstacle while lowering: raw echoes, a couple in a row to skip noise
+        if (liftMotion == MOTION_DOWN && echoWidthUs < OBSTACLE_ECHO_US) {
+            if (++obstacleHits >= OBSTACLE_ECHO_HITS) cutRelays(CUTOFF_OBSTACLE, now);
+        } else {
+            obstacleHits = 0;
+        }
+    }
+}
+
+// Deferred half of an ISR cutoff: logging, state, MQTT
+void serviceCutoff() {
+    if (cutoffReason == CUTOFF_NONE) return;
+
+    portENTER_CRITICAL(&liftMux);
+    CutoffReason reason = cutoffReason;
+    uint32_t latency = cutoffLatencyUs;
+    cutoffReason = CUTOFF_NONE;
+    portEXIT_CRITICAL(&liftMux);
+
+    state.cutoffCount++;
+    state.lastCutoffLatencyUs = latency;
+    if (latency > state.maxCutoffLatencyUs) state.maxCutoffLatencyUs = latency;
+
+    const char* name = reason == CUTOFF_TOP ? "top_limit"
+                     : reason == CUTOFF_BOTTOM ? "bottom_limit"
+                     : "obstacle";
+    mqttLog("[SAFETY] %s - relays cut in ISR (%lu us)\n", name, (unsigned long)latency);
+    stopLift(name);
+}
+
+static float medianOf(const float* values, uint8_t count) {
+    float sorted[ULTRASONIC_FILTER_SIZE];
+    memcpy(sorted, values, count * sizeof(float));
+    // Insertion sort - count is tiny
+    for (uint8_t i = 1; i < count; i++) {
+        float v = sorted[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j] > v) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+    return sorted[count / 2];
+}
+
+// Feed one raw reading through the outlier gate and median window
+static void addUltrasonicReading(float distance) {
+    if (ultrasonic.windowCount > 0) {
+        float median = medianOf(ultrasonic.window, ultrasonic.windowCount);
+        if (fabsf(distance - median) > ULTRASONIC_OUTLIER_CM) {
+            ultrasonic.rejected++;
+            if (++ultrasonic.rejectRun < ULTRASONIC_MAX_REJECTS) return;
+            ultrasonic.windowCount = 0;  // Consistent jump - start over from here
+            ultrasonic.windowNext = 0;
+        }
+    }
+    ultrasonic.rejectRun = 0;
+
+    ultrasonic.window[ultrasonic.windowNext] = distance;
+    ultrasonic.windowNext = (ultrasonic.windowNext + 1) % ULTRASONIC_FILTER_SIZE;
+    if (ultrasonic.windowCount < ULTRASONIC_FILTER_SIZE) ultrasonic.windowCount++;
+
+    state.distanceCm = medianOf(ultrasonic.window, ultrasonic.windowCount);
+    state.ultrasonicOk = true;
+}
+
+static void updateEstimator(float distanceCm, uint32_t nowUs) {
+    float dt = (nowUs - estimator.lastUs) / 1000000.0f;
+    estimator.lastUs = nowUs;
+    if (!estimator.valid || dt <= 0 || dt * 1000.0f > ESTIMATOR_MAX_GAP_MS) {
+        estimator.positionCm = distanceCm;
+        estimator.velocityCmS = 0;
+        estimator.valid = true;
+        return;
+    }
+
+    bool driven = liftMotion != MOTION_NONE || millis() - estimator.relaysOffAt < MOVE_SETTLE_MS;
+    float predicted = estimator.positionCm + estimator.velocityCmS * dt;
+    float residual = distanceCm - predicted;
+    estimator.positionCm = predicted + ESTIMATOR_ALPHA * residual;
+    estimator.velocityCmS = driven ? estimator.velocityCmS + ESTIMATOR_BETA * residual / dt : 0;
+}
+
+void updateUltrasonic() {
+    uint32_t started = micros();
+
+    if (ultrasonic.inFlight) {
+        if (echoReady) {
+            echoReady = false;
+            ultrasonic.inFlight = false;
+            ultrasonic.samples++;
+            ultrasonic.missRun = 0;
+            ultrasonic.lastEchoUs = echoWidthUs;
+
+            // Speed of sound = 343 m/s = 0.0343 cm/us, halved for the round trip
+            addUltrasonicReading((echoWidthUs * 0.0343f) / 2.0f);
+            updateEstimator(state.distanceCm, ultrasonic.triggerUs);
+            state.positionPercent = calculatePositionPercent();
+            hiveLive.notify();  // Position streams to web clients while lifting
+        } else if (started - ultrasonic.triggerUs > ULTRASONIC_TIMEOUT_US) {
+            // Timeout - no echo received
+            echoArmed = false;
+            ultrasonic.inFlight = false;
+            ultrasonic.timeouts++;
+            if (++ultrasonic.missRun >= ULTRASONIC_MAX_MISSES) {
+                state.ultrasonicOk = false;
+                estimator.valid = false;
+                state.positionPercent = calculatePositionPercent();
+                hiveLive.notify();
+            }
+        }
+    }
+
+    // Faster pings while the bed moves
+    unsigned long interval = state.isLifting ? ULTRASONIC_LIFT_INTERVAL : ULTRASONIC_READ_INTERVAL;
+    if (!ultrasonic.inFlight && millis() - lastUltrasonicRead >= interval) {
+        lastUltrasonicRead = millis();
+
+        echoReady = false;
+        echoStartUs = 0;
+        echoArmed = true;
+
+        // Send trigger pulse (10us is the only busy-wait left)
+        digitalWrite(ULTRASONIC_TRIG_PIN, HIGH);
+        delayMicroseconds(10);
+        digitalWrite(ULTRASONIC_TRIG_PIN, LOW);
+
+        ultrasonic.triggerUs = micros();
+        ultrasonic.inFlight = true;
+    }
+
+    ultrasonic.readUs = micros() - started;
+    if (ultrasonic.readUs > ultrasonic.readMaxUs) ultrasonic.readMaxUs = ultrasonic.readUs;
+}
+
+void readReedSwitches() {
+    // Reed switches are active LOW (connected to ground when magnet present)
+    bool topTriggered = (digitalRead(REED_TOP_PIN) == LOW);
+    bool bottomTriggered = (digitalRead(REED_BOTTOM_PIN) == LOW);
+
+    // Detect changes
+    if (topTriggered != state.atTopLimit) {
+        state.atTopLimit = topTriggered;
+        hiveDebug("[REED] Top limit: %s\n", topTriggered ? "TRIGGERED" : "clear");
+    }
+    if (bottomTriggered != state.atBottomLimit) {
+        state.atBottomLimit = bottomTriggered;
+        hiveDebug("[REED] Bottom limit: %s\n", bottomTriggered ? "TRIGGERED" : "clear");
+    }
+}
+
+void updateSensors() {
+    HIVE_PERF_SCOPE("updateSensors");
+    // Ultrasonic runs in the background - this only triggers/collects
+    updateUltrasonic();
+
+    // Reed switches can be read every loop (they're fast)
+    readReedSwitches();
+}
+
+bool isSafeToMove(const String& direction) {
+    // Check limit switches
+    if (direction == "raise" && state.atTopLimit) {
+        Serial.println("[SAFETY] Already at top limit");
+        return false;
+    }
+    if (direction == "lower" && state.atBottomLimit) {
+        Serial.println("[SAFETY] Already at bottom limit");
+        return false;
+    }
+
+    // Check ultrasonic when lowering
+    if (direction == "lower" && state.ultrasonicOk) {
+        if (state.distanceCm > 0 && state.distanceCm < MIN_SAFE_DISTANCE_CM) {
+            Serial.printf("[SAFETY] Obstacle below! Distance: %.1f cm\n", state.distanceCm);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void calibratePosition(const String& position) {
+    if (!state.ultrasonicOk) {
+        Serial.println("[CALIBRATE] Error: Ultrasonic sensor not reading");
+        return;
+    }
+
+    if (position == "top") {
+        config.calibratedTopCm = state.distanceCm;
+        Serial.printf("[CALIBRATE] Top position set to %.1f cm\n", config.calibratedTopCm);
+    } else if (position == "bottom") {
+        config.calibratedBottomCm = state.distanceCm;
+        Serial.printf("[CALIBRATE] Bottom position set to %.1f cm\n", config.calibratedBottomCm);
+    }
+
+    saveConfig();
+
+    // Recalculate position
+    state.positionPercent = calculatePositionPercent();
+    hive.publishState();
+    hiveLive.notify();
+}
+
+// Estimate predicted to now (0% = bottom, 100% = top); only meaningful
+// while positionPercent >= 0
+float estimatedPercent() {
+    float range = config.calibratedBottomCm - config.calibratedTopCm;
+    float sinceReading = min((micros() - estimator.lastUs) / 1000000.0f, ESTIMATOR_MAX_GAP_MS / 1000.0f);
+    float distance = estimator.positionCm + estimator.velocityCmS * sinceReading;
+    return (config.calibratedBottomCm - distance) / range * 100.0f;
+}
+
+// %/s, + = raising
+float estimatedSpeed() {
+    float range = config.calibratedBottomCm - config.calibratedTopCm;
+    return -estimator.velocityCmS / range * 100.0f;
+}
+
+int calculatePositionPercent() {
+    // Need both calibration points
+    if (config.calibratedTopCm == 0 || config.calibratedBottomCm == 0) {
+        return -1;  // Not calibrated
+    }
+    if (!state.ultrasonicOk || !estimator.valid) {
+        return -1;  // No valid reading
+    }
+
+    // Calculate percentage (0% = bottom, 100% = top)
+    float range = config.calibratedBottomCm - config.calibratedTopCm;
+    if (range <= 0) {
+        return -1;  // Invalid calibration
+    }
+
+    float fromBottom = config.calibratedBottomCm - estimator.positionCm;
+    int percent = (int)((fromBottom / range) * 100);
+
+    // Clamp to 0-100
+    if (percent < 0) percent = 0;
+    if (percent > 100) percent = 100;
+
+    return percent;
+}
+
+// ============== Setup ==============
+
+void setup() {
+    Serial.begin(115200);
+    delay(500);
+
+    Serial.println("\n\n=== BedLiftBee ===");
+    Serial.println("Happy Jack Bed Lift Controller");
+    Serial.printf("Firmware: %s\n", FIRMWARE_VERSION);
+
+    // Initialize GPIO
+    pinMode(RELAY_UP_PIN, OUTPUT);
+    pinMode(RELAY_DOWN_PIN, OUTPUT);
+    pinMode(LED_PIN, OUTPUT);
+
+    // Ensure relays are OFF at startup
+    digitalWrite(RELAY_UP_PIN, RELAY_OFF);
+    digitalWrite(RELAY_DOWN_PIN, RELAY_OFF);
+    digitalWrite(LED_PIN, HIGH);  // LED off (active-low)
+
+    Serial.println("[RELAYS] Initialized - both OFF");
+
+    // Setup safety sensors
+    setupSensors();
+
+    // Generate device ID
+    hive.begin(beeInfo);
+    const String& deviceId = hive.deviceId();
+
+    // Load configuration
+    loadConfig();
+
+    // Setup WiFi Manager
+    WiFiManagerParameter mqttServerParam("mqtt_server", "MQTT Server", config.mqttServer, 64);
+    WiFiManagerParameter mqttPortParam("mqtt_port", "MQTT Port", String(config.mqttPort).c_str(), 6);
+    WiFiManagerParameter deviceNameParam("device_name", "Device Name", config.deviceName, 32);
+    WiFiManagerParameter liftDurationParam("lift_duration", "Lift Duration (ms)", String(config.liftDuration).c_str(), 8);
+
+    wifiManager.addParameter(&mqttServerParam);
+    wifiManager.addParameter(&mqttPortParam);
+    wifiManager.addParameter(&deviceNameParam);
+    wifiManager.addParameter(&liftDurationParam);
+
+    String apName = "BedLiftBee-Setup-" + deviceId.substring(deviceId.length() - 4);
+    wifiManager.setConfigPortalTimeout(180);
+
+    // Cached BSSID/channel skips the scan; portal and parameter save only on a miss
+    if (!hiveWiFi.fastConnect()) {
+        Serial.println("Starting WiFi Manager...");
+        if (!wifiManager.autoConnect(apName.c_str())) {
+            Serial.println("Failed to connect, restarting...");
+            delay(3000);
+            ESP.restart();
+        }
+
+        // Save any updated parameters
+        strcpy(config.mqttServer, mqttServerParam.getValue());
+        config.mqttPort = atoi(mqttPortParam.getValue());
+        strcpy(config.deviceName, deviceNameParam.getValue());
+        config.liftDuration = atoi(liftDurationParam.getValue());
+        if (config.liftDuration < 500) config.liftDuration = DEFAULT_LIFT_DURATION;
+        saveConfig();
+    }
+    hiveWiFi.remember();
+
+    Serial.printf("WiFi connected! IP: %s\n", WiFi.localIP().toString().c_str());
+
+    // Setup mDNS
+    String mdnsName = "bedliftbee-" + deviceId.substring(deviceId.length() - 6);
+    if (MDNS.begin(mdnsName.c_str())) {
+        Serial.printf("mDNS: http://%s.local\n", mdnsName.c_str());
+        MDNS.addService("http", "tcp", 80);
+    }
+
+    // Setup MQTT
+    hive.onConnect(onConnect);
+    hive.onCommands(commands);
+    hive.onDiscovery(onDiscovery);
+    hive.onState(onState);
+    hive.onHealth(onHealth);
+    hive.setupMQTT(config);
+    liftTopic = hive.topicFor(deviceId.c_str(), "lift");
+
+    // Setup Web Server
+    setupWebServer();
+
+#if HIVE_BENCH
+    runBenchmarks();
+#endif
+
+    Serial.println("Setup complete!\n");
+}
+
+// ============== Benchmarks ==============
+
+#if HIVE_BENCH
+#define BENCH_ULTRASONIC_US 12000    // Trigger to echo collected (~2m, bed fully raised)
+#define BENCH_SENSORS_US 200         // updateSensors() per loop, echo in flight or not
+
+// Benchmark build (env:bedliftbee-bench), before loop() starts lifting
+void runBenchmarks() {
+    hiveBench.start();
+    hiveBench.runCore();
+
+    // Trigger to the falling-edge ISR; the HC-SR04 needs ~60ms between pings
+    hiveBench.begin("ultrasonic_capture", BENCH_ULTRASONIC_US);
+    for (int i = 0; i < 10; i++) {
+        delay(60);
+        echoReady = false;
+        echoStartUs = 0;
+        echoArmed = true;
+
+        uint32_t started = micros();
+        digitalWrite(ULTRASONIC_TRIG_PIN, HIGH);
+        delayMicroseconds(10);
+        digitalWrite(ULTRASONIC_TRIG_PIN, LOW);
+        while (!echoReady && micros() - started < ULTRASONIC_TIMEOUT_US) {
+            delayMicroseconds(1);
+        }
+        if (echoReady) hiveBench.sample(micros() - started);
+    }
+    echoArmed = false;
+    echoReady = false;
+    hiveBench.end();
+
+    hiveBench.run("updateSensors", 200, BENCH_SENSORS_US, [] { updateSensors(); });
+
+    hiveBench.finish();
+}
+#endif
+
+// ============== Main Loop ==============
+
+void loop() {
+    // Update safety sensors
+    updateSensors();
+
+    // Update bed lift timer (includes safety checks)
+    updateLift();
+
+    // MQTT reconnect, health/state publishing, buffered logs
+    hive.loop();
+    hiveLive.loop();
+
+    delay(10);
+}
+
+// ============== Async Web Server ==============
+
+// /api/status and the live event stream
+void buildStatus(JsonDocument& doc) {
+    JsonObject settings = hiveStatusJson(doc, config);
+    settings["lift_duration"] = config.liftDuration;
+
+    doc["isLifting"] = state.isLifting;
+    doc["direction"] = state.liftDirection;
+    doc["relayUp"] = state.relayUp;
+    doc["relayDown"] = state.relayDown;
+    doc["liftDuration"] = config.liftDuration;
+    // Safety sensors
+    doc["distanceCm"] = state.distanceCm;
+    doc["ultrasonicOk"] = state.ultrasonicOk;
+    doc["atTopLimit"] = state.atTopLimit;
+    doc["atBottomLimit"] = state.atBottomLimit;
+    doc["positionPercent"] = state.positionPercent;
+    doc["lastStopReason"] = state.lastStopReason;
+    doc["calibratedTopCm"] = config.calibratedTopCm;
+    doc["calibratedBottomCm"] = config.calibratedBottomCm;
+    doc["targetPercent"] = state.targetPercent;
+    doc["stopLeadMs"] = config.stopLeadMs;
+    doc["stopErrorPercent"] = state.stopErrorPercent;
+    doc["moves"] = state.moves;
+}
+
+void setupWebServer() {
+    // Pages are gzipped into flash at build time and fill themselves from /api/status
+    hiveServeAsset(webServer, "/", WEB_INDEX_HTML);
+    hiveServeAsset(webServer, "/config", WEB_CONFIG_HTML);
+
+    // Config save (POST)
+    webServer.on("/config", HTTP_POST, [](AsyncWebServerRequest *request) {
+        if (request->hasParam("device_name", true)) {
+            strncpy(config.deviceName, request->getParam("device_name", true)->value().c_str(), sizeof(config.deviceName) - 1);
+        }
+        if (request->hasParam("mqtt_server", true)) {
+            strncpy(config.mqttServer, request->getParam("mqtt_server", true)->value().c_str(), sizeof(config.mqttServer) - 1);
+        }
+        if (request->hasParam("mqtt_port", true)) {
+            config.mqttPort = request->getParam("mqtt_port", true)->value().toInt();
+        }
+        if (request->hasParam("lift_duration", true)) {
+            config.liftDuration = request->getParam("lift_duration", true)->value().toInt();
+            if (config.liftDuration < 500) config.liftDuration = DEFAULT_LIFT_DURATION;
+        }
+
+        saveConfig();
+        request->redirect("/");
+        delay(500);
+        ESP.restart();
+    });
+
+    // Lift control endpoint
+    webServer.on("/lift", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (request->hasParam("dir")) {
+            String dir = request->getParam("dir")->value();
+            if (dir == "raise") {
+                startLift("raise");
+                request->send(200, "text/plain", "RAISING");
+            } else if (dir == "lower") {
+                startLift("lower");
+                request->send(200, "text/plain", "LOWERING");
+            } else if (dir == "stop") {
+                stopLift();
+                request->send(200, "text/plain", "STOPPED");
+            } else {
+                request->send(400, "text/plain", "Invalid direction");
+            }
+        } else if (request->hasParam("to")) {
+            moveToPercent(request->getParam("to")->value().toInt());
+            request->send(200, "text/plain", state.targetPercent >= 0 ? "MOVING" : "NOT MOVING");
+        } else {
+            request->send(400, "text/plain", "Missing dir or to parameter");
+        }
+    });
+
+    // Reboot
+    webServer.on("/reboot", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (request->hasParam("reset") && request->getParam("reset")->value() == "1") {
+            wifiManager.resetSettings();
+            hiveWiFi.forget();
+        }
+        request->send(200, "text/plain", "Rebooting...");
+        delay(500);
+        ESP.restart();
+    });
+
+    // API endpoint for JSON status (also feeds the web pages)
+    webServer.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        buildStatus(doc);
+        hiveSendJson(request, doc);
+    });
+
+    // Live status: full snapshot on connect, then changed fields as they happen
+    hiveLive.begin(webServer, buildStatus);
+
+    // Loop/scope timings and stack high-water marks (HIVE_PERF=1 builds)
+    hiveServePerf(webServer);
+
+    // Calibration endpoint
+    webServer.on("/calibrate", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (request->hasParam("pos")) {
+            String pos = request->getParam("pos")->value();
+            if (pos == "top" || pos == "bottom") {
+                calibratePosition(pos);
+                request->send(200, "text/plain", "Calibrated " + pos);
+            } else {
+                request->send(400, "text/plain", "Invalid position (use top or bottom)");
+            }
+        } else {
+            request->send(400, "text/plain", "Missing pos parameter");
+        }
+    });
+
+    webServer.begin();
+    Serial.println("[HTTP] Async web server started");
+}
+
+// ============== Configuration Storage ==============
+
+void loadConfig() {
+    HiveConfigSource source = hiveConfig.load("bedliftbee", config, CONFIG_VERSION);
+    if (source == HIVE_CONFIG_LEGACY) {
+        preferences.begin("bedliftbee", true);
+        loadHiveConfig(preferences, config, "BedLiftBee");
+        config.liftDuration = preferences.getULong("liftDuration", DEFAULT_LIFT_DURATION);
+        preferences.end();
+    }
+    if (source != HIVE_CONFIG_BLOB) saveConfig();
+
+    Serial.printf("[Config] Loaded in %lu us: name=%s, mqtt=%s:%d, duration=%lu\n",
+                  (unsigned long)hiveConfig.loadUs(), config.deviceName, config.mqttServer, config.mqttPort,
+                  config.liftDuration);
+}
+
+void saveConfig() {
+    // No flash write unless a field changed
+    if (!hiveConfig.save("bedliftbee", config, CONFIG_VERSION)) return;
+
+    Serial.printf("[Config] Saved in %lu us\n", (unsigned long)hiveConfig.saveUs());
+}